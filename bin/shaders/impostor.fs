@@ -0,0 +1,65 @@
+#version 330 core
+in vec3 FragPos;
+flat in vec3 Center;
+flat in float Radius;
+flat in mat3 Rotation;
+flat in uint MaterialIndex;
+flat in float Ambient;
+
+out vec4 FragColor;
+
+// one layer per material
+struct Material {
+    sampler2DArray diffuse;
+    sampler2DArray normal;
+    sampler2DArray specular;
+};
+
+// FrameUniforms, the point lights and ComputePointLights come from lighting.glsl
+
+uniform Material material;
+
+const float PI = 3.14159265;
+
+void main()
+{
+    // intersect the view ray with the sphere
+    vec3 ray = normalize(FragPos - view_position.xyz);
+    vec3 center_to_camera = view_position.xyz - Center;
+    float b = dot(center_to_camera, ray);
+    float h = b * b - dot(center_to_camera, center_to_camera) + Radius * Radius;
+    if (h < 0.0)
+        discard;
+    vec3 hit = view_position.xyz + (-b - sqrt(h)) * ray;
+
+    vec4 clip_position = view_projection_matrix * vec4(hit, 1.0);
+    gl_FragDepth = (clip_position.z / clip_position.w) * 0.5 + 0.5;
+
+    // same texture mapping and tangents as the sphere models
+    vec3 N = (hit - Center) / Radius;
+    vec3 model_normal = transpose(Rotation) * N;
+    float longitude = atan(model_normal.z, model_normal.x);
+    vec2 uv = vec2(0.5 - longitude / (2.0 * PI), 0.5 + asin(clamp(model_normal.y, -1.0, 1.0)) / PI);
+    vec3 T = normalize(Rotation * vec3(sin(longitude), 0.0, -cos(longitude)));
+    vec3 B = cross(N, T);
+    mat3 TBN = transpose(mat3(T, B, N));
+
+    // u jumps by one across the seam, which must not select the smallest mipmap
+    vec2 uv_dx = dFdx(uv);
+    vec2 uv_dy = dFdy(uv);
+    uv_dx.x -= round(uv_dx.x);
+    uv_dy.x -= round(uv_dy.x);
+
+    vec3 MaterialTexCoords = vec3(uv, float(MaterialIndex));
+    vec3 tangent_space_normal = normalize(textureGrad(material.normal, MaterialTexCoords, uv_dx, uv_dy).rgb * 2.0 - 1.0);
+    vec3 lightDir = normalize(light_position.xyz - hit);
+    vec3 tangent_space_light_direction = TBN * lightDir;
+
+    vec3 diffuse_color = textureGrad(material.diffuse, MaterialTexCoords, uv_dx, uv_dy).rgb;
+    vec3 light_intensity = vec3(max(0.0, dot(tangent_space_normal, tangent_space_light_direction)));
+    light_intensity += ComputePointLights(hit, tangent_space_normal, TBN);
+    vec3 diffuse = light_intensity * diffuse_color;
+    vec3 ambient = Ambient * diffuse_color;
+
+    FragColor = vec4(ambient + diffuse, 1.0);
+}
@@ -0,0 +1,45 @@
+#version 330 core
+layout (location = 0) in vec2 corner;
+// per-instance attributes, the same as the sphere models
+layout (location = 4) in mat4 model_to_world_matrix;
+layout (location = 8) in uint material_index;
+layout (location = 9) in float ambient;
+
+out vec3 FragPos;
+flat out vec3 Center;
+flat out float Radius;
+flat out mat3 Rotation;
+flat out uint MaterialIndex;
+flat out float Ambient;
+
+layout (std140) uniform FrameUniforms
+{
+    mat4 view_projection_matrix;
+    vec4 view_position;
+    vec4 light_position;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    vec4 light_cluster_parameters;
+};
+
+void main()
+{
+    // the matrix scales a unit sphere uniformly
+    Center = model_to_world_matrix[3].xyz;
+    Radius = length(model_to_world_matrix[0].xyz);
+    Rotation = mat3(model_to_world_matrix) / Radius;
+    MaterialIndex = material_index;
+    Ambient = ambient;
+
+    vec3 to_camera = view_position.xyz - Center;
+    float distance = length(to_camera);
+    to_camera /= distance;
+    vec3 up_hint = abs(to_camera.y) > 0.99 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up_hint, to_camera));
+    vec3 up = cross(to_camera, right);
+
+    // seen in perspective, the silhouette of the sphere on the plane through its center is a bit larger than the sphere
+    float half_size = Radius * distance / sqrt(max(distance * distance - Radius * Radius, 1e-6));
+    FragPos = Center + (corner.x * right + corner.y * up) * half_size;
+    gl_Position = view_projection_matrix * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,43 @@
+// placed after the #version line of the fragment shaders lit by the point lights (shader.fs and impostor.fs), right after
+// the cluster grid constants of LightClusters::GetShaderConstants
+
+layout (std140) uniform FrameUniforms
+{
+    mat4 view_projection_matrix;
+    vec4 view_position;
+    vec4 light_position;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    vec4 light_cluster_parameters;
+};
+
+// point lights binned into clusters of the view frustum
+uniform usamplerBuffer light_clusters; // offset and count of the lights of every cluster
+uniform usamplerBuffer light_indices;
+uniform samplerBuffer lights; // position and radius then color of every light
+
+// intensity of the point lights reaching a point, seen by a tangent space normal
+vec3 ComputePointLights(vec3 position, vec3 tangent_space_normal, mat3 TBN)
+{
+    // w is the view depth with a perspective projection
+    vec4 clip_position = view_projection_matrix * vec4(position, 1.0);
+    vec2 tile = clamp((clip_position.xy / clip_position.w * 0.5 + 0.5) * vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y),
+        vec2(0.0), vec2(CLUSTER_COUNT_X - 1u, CLUSTER_COUNT_Y - 1u));
+    float slice = clamp(log(max(clip_position.w, light_cluster_parameters.x) / light_cluster_parameters.x) *
+        light_cluster_parameters.y, 0.0, float(CLUSTER_COUNT_Z - 1u));
+    uvec2 range = texelFetch(light_clusters, int((uint(slice) * CLUSTER_COUNT_Y + uint(tile.y)) * CLUSTER_COUNT_X + uint(tile.x))).rg;
+
+    vec3 intensity = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++)
+    {
+        int light = int(texelFetch(light_indices, int(range.x + i)).r);
+        vec4 light_position_and_radius = texelFetch(lights, 2 * light);
+        vec3 to_light = light_position_and_radius.xyz - position;
+        float distance_squared = dot(to_light, to_light);
+        // fades out smoothly, down to nothing at the radius
+        float falloff = clamp(1.0 - distance_squared / (light_position_and_radius.w * light_position_and_radius.w), 0.0, 1.0);
+        float lambert = max(0.0, dot(tangent_space_normal, TBN * (to_light * inversesqrt(max(distance_squared, 1e-8)))));
+        intensity += texelFetch(lights, 2 * light + 1).rgb * (falloff * falloff * lambert);
+    }
+    return intensity;
+}
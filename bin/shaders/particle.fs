@@ -1,12 +1,12 @@
 #version 330 core
 
 in vec2 texCoords;
+in vec4 particleColor;
 out vec4 FragColor;
 
 uniform sampler2D sprite;
-//uniform vec4 color;
 
 void main()
 {
-    FragColor = texture(sprite, texCoords); // + color
+    FragColor = texture(sprite, texCoords) * particleColor;
 }
\ No newline at end of file
@@ -1,15 +1,26 @@
 #version 330 core
 
 layout(location = 0) in vec3 vertex;
+// per-instance attributes
+layout(location = 1) in vec4 offset_and_scale;
+layout(location = 2) in vec4 color;
 
 out vec2 texCoords;
+out vec4 particleColor;
 
-uniform mat4 view_projection_matrix;
-uniform vec3 offset;
-uniform float scale;
+layout (std140) uniform FrameUniforms
+{
+    mat4 view_projection_matrix;
+    vec4 view_position;
+    vec4 light_position;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    vec4 light_cluster_parameters;
+};
 
 void main()
 {
     texCoords = vertex.xy;
-    gl_Position = view_projection_matrix * vec4((vertex.xyz*scale) + offset, 1.0);
+    particleColor = color;
+    gl_Position = view_projection_matrix * vec4((vertex.xyz*offset_and_scale.w) + offset_and_scale.xyz, 1.0);
 }
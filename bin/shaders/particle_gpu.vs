@@ -0,0 +1,27 @@
+#version 330 core
+
+layout(location = 0) in vec4 vertex;
+// per-instance attributes, straight from the particles written by particle_update.vs
+layout(location = 1) in vec4 position_and_life;
+
+out vec2 texCoords;
+out vec4 particleColor;
+
+layout (std140) uniform FrameUniforms
+{
+    mat4 view_projection_matrix;
+    vec4 view_position;
+    vec4 light_position;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    vec4 light_cluster_parameters;
+};
+
+void main()
+{
+    // the size is proportionate to the time left, so dead particles shrink to nothing and are never rasterized
+    float scale = max(position_and_life.w, 0.0) / 8.0;
+    texCoords = vertex.xy;
+    particleColor = vec4(1.0);
+    gl_Position = view_projection_matrix * vec4((vertex.xyz * scale) + position_and_life.xyz, 1.0);
+}
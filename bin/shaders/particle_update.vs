@@ -0,0 +1,61 @@
+#version 330 core
+
+// particle read from the previous step
+layout(location = 1) in vec4 position_and_life;
+layout(location = 2) in vec4 velocity;
+
+// particle captured for the next step
+out vec4 out_position_and_life;
+out vec4 out_velocity;
+
+uniform float delta_time;
+// slots first_spawned to first_spawned + spawn_count - 1, wrapping around the capacity, are respawned this step
+uniform uint first_spawned;
+uniform uint spawn_count;
+uniform uint capacity;
+uniform uint seed;
+uniform uint step;
+uniform vec3 spawn_origin;
+
+// PCG hash, decorrelates consecutive inputs well enough for particles
+uint Hash(uint value)
+{
+    uint state = value * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// uniform in [0, 1), advancing the state
+float Random(inout uint state)
+{
+    state = Hash(state);
+    return float(state >> 8u) * (1.0 / 16777216.0);
+}
+
+void main()
+{
+    uint slot = uint(gl_VertexID);
+    vec3 position = position_and_life.xyz;
+    vec3 particle_velocity = velocity.xyz;
+    float life = position_and_life.w;
+
+    // same ranges as CPU particles: a 10 unit cube from the origin, and up to 5 units per second on every axis
+    if ((slot + capacity - first_spawned) % capacity < spawn_count)
+    {
+        uint state = Hash(Hash(seed) ^ step) ^ Hash(slot);
+        position = spawn_origin + vec3(Random(state), Random(state), Random(state)) * 10.0;
+        particle_velocity = vec3(Random(state), Random(state), Random(state)) * 10.0 - 5.0;
+        life = 1.0;
+    }
+
+    // spawned particles move from this step on too
+    life -= delta_time;
+    if (life > 0.0)
+    {
+        particle_velocity *= 1.0 - delta_time;
+        position -= particle_velocity * delta_time;
+    }
+
+    out_position_and_life = vec4(position, life);
+    out_velocity = vec4(particle_velocity, 0.0);
+}
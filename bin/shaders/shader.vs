@@ -3,16 +3,26 @@ layout (location = 0) in vec3 model_position;
 layout (location = 1) in vec3 model_normal;
 layout (location = 2) in vec3 model_tangent;
 layout (location = 3) in vec2 model_texcoord;
+// per-instance attributes
+layout (location = 4) in mat4 model_to_world_matrix;
+layout (location = 8) in uint material_index;
+layout (location = 9) in float ambient;
 
 out vec3 FragPos;
 out vec2 TexCoords;
 out mat3 TBN;
+flat out uint MaterialIndex;
+flat out float Ambient;
 
-uniform mat4 model_to_world_matrix;
-uniform mat4 view_projection_matrix;
-
-uniform vec3 lightPos;
-uniform vec3 viewPos;
+layout (std140) uniform FrameUniforms
+{
+    mat4 view_projection_matrix;
+    vec4 view_position;
+    vec4 light_position;
+    vec4 light_diffuse;
+    vec4 light_specular;
+    vec4 light_cluster_parameters;
+};
 
 void main()
 {
@@ -20,6 +30,8 @@ void main()
 
     gl_Position = view_projection_matrix * vec4(FragPos, 1.0);
     TexCoords = model_texcoord;
+    MaterialIndex = material_index;
+    Ambient = ambient;
     
     mat3 model_to_world_matrix = mat3(model_to_world_matrix);
     vec3 N = normalize(model_to_world_matrix * model_normal);
@@ -10,22 +10,82 @@
 
 // engine headers
 #include "nge_graphics.hh"
+#include "nge_gpu_particles.hh"
+#include "nge_culling.hh"
+#include "nge_dynamic_resolution.hh"
+#include "nge_icosphere.hh"
+#include "nge_impostor.hh"
+#include "nge_lighting.hh"
+#include "nge_pipeline.hh"
+#include "nge_profiler.hh"
+#include "nge_render_queue.hh"
+#include "nge_program_cache.hh"
+#include "nge_random.hh"
+#include "nge_shader.hh"
+#include "nge_state_cache.hh"
+#include "nge_streaming.hh"
 #include "nge_timing.hh"
 #include "nge_math.hh"
 
 // LearnOpenGL headers (TODO: get rid of this)
-#include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 
 // std headers
 #include <map>
+#include <array>
 #include <span>
-#include <istream>
-#include <fstream>
+#include <vector>
+#include <algorithm>
 #include <cmath>
+#include <optional>
 
 class NeutronGame final : public nge::WindowEventHandler
 {
+public:
+	struct Settings
+	{
+		// simulate the particles on the GPU with transform feedback, instead of on the simulation thread
+		bool use_gpu_particles = false;
+		// glowing debris circling the sun, each of them a point light
+		u32 debris_count = 0;
+		// GPU time per frame which the render resolution adapts to, or none to always render at the window resolution
+		std::optional<nge::timing::Seconds> frame_budget;
+	};
+
+private:
+	// state of the world handed from the simulation thread to the render thread, written once and only read after
+	struct WorldSnapshot
+	{
+		struct PlanetState
+		{
+			u32 id;
+			nge::math::Vector3 center;
+			float radius;
+			nge::graphics::InstanceFormat instance;
+		};
+
+		std::vector<PlanetState> planets;
+		std::vector<ParticleInstance> particles;
+		std::vector<nge::graphics::PointLight> lights;
+	};
+
+	// glowing debris circling the sun in the plane of the planets, only seen through the light it sheds on them
+	struct GlowingDebris
+	{
+		float orbit_radius;
+		float angle; // around the sun, in radians
+		float angular_speed; // in radians per second
+		float height; // above the plane of the planets
+		nge::math::Vector3 color;
+	};
+
+	// what the render thread remembers of each planet between frames, to avoid switching back and forth
+	struct PlanetDrawState
+	{
+		u32 lod_level = 0; // level of detail the planet was drawn with
+		bool is_impostor = false; // whether it was drawn as an impostor
+	};
+
 	bool needs_to_stop; // does the game need to quit immediately?
 	Camera camera;
 	bool firstMouse;
@@ -40,14 +100,52 @@ class NeutronGame final : public nge::WindowEventHandler
 	bool stop;
 	float stopTimeout;
 
+	// only touched by the simulation thread once it is started
 	std::vector<Planet> planets;
-
-	Shader skybox_shader;
-	Shader particle_shader;
-	Shader planet_shader;
-
-	// sphere planet model, which is reused for every planet
-	nge::graphics::Model planet_model;
+	std::vector<GlowingDebris> debris;
+
+	// compiled programs from previous launches
+	nge::graphics::ProgramCache program_cache;
+	nge::graphics::Shader skybox_shader;
+	nge::graphics::Shader particle_shader;
+	nge::graphics::Shader planet_shader;
+	nge::graphics::Shader impostor_shader;
+	// particles simulated on the GPU rather than on the simulation thread, only compiled when used
+	bool use_gpu_particles;
+	std::optional<nge::graphics::Shader> particle_update_shader;
+	std::optional<nge::graphics::Shader> gpu_particle_shader;
+
+	// everything rewritten every frame: uniforms shared by every program, planet instances and particles
+	nge::graphics::StreamingBuffer streaming_buffer;
+
+	// sphere planet models of increasing detail, which are reused for every planet
+	nge::graphics::IcosphereLodChain planet_lods;
+	// ray-traced quads drawing the planets too small on screen for a mesh
+	nge::graphics::SphereImpostors planet_impostors;
+	// maps of every planet type, bound once for all planets
+	PlanetMaterials planet_materials;
+	// indexed by planet id
+	std::vector<PlanetDrawState> planet_draw_states;
+	// bounds of every planet and the ones in view, rebuilt every frame
+	nge::graphics::BoundingSpheres planet_bounds;
+	std::vector<u32> visible_planets;
+	// per-instance data of every visible planet for each level of detail, rebuilt every frame
+	std::array<std::vector<nge::graphics::InstanceFormat>, nge::graphics::IcosphereLodChain::LEVEL_COUNT> planet_instances;
+	std::vector<nge::graphics::InstanceFormat> planet_impostor_instances;
+
+	// point lights of the frame binned into clusters of the view, and the textures the planet programs read them from
+	nge::graphics::LightClusters light_clusters;
+	nge::graphics::LightClusterBuffers light_cluster_buffers;
+
+	// every draw of the frame, sorted before being executed
+	nge::graphics::RenderQueue render_queue;
+
+	// size of the window, which the scene is upscaled to when rendered at a lower resolution
+	nge::Extent2D viewport;
+	nge::graphics::ScaledRenderTarget scene_target;
+	// GPU time of every frame, and the resolution it sets when there is a frame budget
+	nge::graphics::GpuFrameTimer gpu_frame_timer;
+	std::optional<nge::graphics::ResolutionScaler> resolution_scaler;
 
 	Planet sun;
 	Planet mercury;
@@ -55,8 +153,30 @@ class NeutronGame final : public nge::WindowEventHandler
 	Planet moon;
 	Planet mars;
 
-	static constexpr u32 EARTH_MOON_MASS = 100;
 	static constexpr u32 SUN_MASS = 100000000;
+	// depth range of the projection, sufficient so it doesn't crop objects
+	static constexpr float NEAR_PLANE = 0.1f;
+	static constexpr float FAR_PLANE = 1024.0f;
+	// glowing debris orbits and colors are the same from one run to the next
+	static constexpr u64 DEBRIS_SEED = 0x646562726973; // "debris"
+	// distance at which the light of a glowing debris fades out
+	static constexpr float DEBRIS_LIGHT_RADIUS = 4.0f;
+	// where compiled programs are kept between launches
+	static constexpr const char* PROGRAM_CACHE_DIRECTORY = "cache/programs";
+	// most bytes streamed in a frame, far more than the planets and particles need, plus room for the fullest light clusters
+	static constexpr usize STREAMING_BUFFER_CAPACITY = (1 << 20) + nge::graphics::LightClusterBuffers::MAX_STREAMED_SIZE;
+	// where captures started and stopped with the P key are saved
+	static constexpr const char* TRACE_PATH = "neutron_trace.json";
+
+	// steps physics, planet rotations and particles while the previous frame is drawn, last so that it stops first
+	nge::SimulationThread<WorldSnapshot> simulation;
+
+	// shared by the fragment shaders lit by the point lights, with the cluster grid of LightClusters
+	static std::string GetLightingHeader()
+	{
+		return nge::graphics::LightClusters::GetShaderConstants() +
+			nge::graphics::Shader::ReadSourceFile("shaders/lighting.glsl");
+	}
 
 	void ProcessKeyPress(const u32 key_code, const u32 action) override
 	{
@@ -76,6 +196,24 @@ class NeutronGame final : public nge::WindowEventHandler
 			stopTimeout = .2f;
 			stop = !stop;
 		}
+
+#if !SHIPPING_BUILD
+		// starts a capture of the profiler, or stops it and saves it for chrome://tracing or ui.perfetto.dev
+		if (key_code == GLFW_KEY_P && action == GLFW_PRESS)
+		{
+			auto& profiler = nge::profiling::Profiler::Get();
+			if (!profiler.IsCapturing())
+			{
+				profiler.StartCapture();
+			}
+			else
+			{
+				profiler.StopCapture();
+				const usize event_count = profiler.ExportChromeTrace(TRACE_PATH);
+				std::cout << "Saved " << event_count << " profiled events to " << TRACE_PATH << '\n';
+			}
+		}
+#endif
 	}
 
 	void ProcessMouseMotion(const float x, const float y) override
@@ -85,37 +223,85 @@ class NeutronGame final : public nge::WindowEventHandler
 
 	void ProcessViewportResize(const nge::Extent2D& dimensions) override
 	{
-//		camera.ProcessViewportResize(width, height);
+		// minimized windows have no pixels to draw into
+		if (dimensions.width == 0 || dimensions.height == 0)
+			return;
+
+		viewport = dimensions;
+		scene_target.Resize(dimensions);
+	}
+
+	// streams the instances front to back and submits their draw with a model or the impostors, if any
+	template<typename Drawable>
+	void SubmitPlanets(std::vector<nge::graphics::InstanceFormat>& instances, const Drawable& drawable,
+		const nge::graphics::Shader& shader)
+	{
+		if (instances.empty())
+			return;
+
+		const nge::math::Vector3 view_position = camera.Position;
+		auto get_distance = [&view_position](const nge::graphics::InstanceFormat& instance)
+		{
+			return glm::distance(nge::math::Vector3(instance.model_to_world_matrix[3]), view_position);
+		};
+		std::sort(instances.begin(), instances.end(),
+			[&get_distance](const nge::graphics::InstanceFormat& a, const nge::graphics::InstanceFormat& b)
+			{
+				return get_distance(a) < get_distance(b);
+			});
+		nge::graphics::DrawPacket packet = drawable.MakeDrawPacket(
+			streaming_buffer.Write(std::span<const nge::graphics::InstanceFormat>(instances)));
+		packet.sort_key = nge::graphics::RenderQueue::MakeSortKey(nge::graphics::RenderLayer::Opaque, shader.GetHandle(),
+			planet_materials.GetMaterialID(), get_distance(instances.front()));
+		packet.program = shader.GetHandle();
+		packet.state.depth_func = GL_LEQUAL;
+		planet_materials.AddTextures(packet);
+		render_queue.Submit(packet);
 	}
 
-	// factory function to create a Model given a file path to an MDL file
-	static nge::graphics::Model CreateModelFromFile(const std::string_view& file_path)
+	// culls the planets and submits the visible ones, grouped by level of detail
+	void SubmitVisiblePlanets(const WorldSnapshot& world, const nge::graphics::Frustum& frustum,
+		const nge::math::Matrix4& projection)
 	{
-		std::ifstream mdl_file(file_path.data(), std::ios::binary);
-		if (!mdl_file.is_open())
-			throw std::runtime_error("Failed to open an MDL file for reading.");
-
-		// read vertices
-		u32 vertex_count;
-		mdl_file.read((char *) &vertex_count, sizeof(u32));
-		assert(vertex_count < 10000); // sanity check
-		std::vector<nge::graphics::VertexFormat> vertices;
-		vertices.resize(vertex_count);
-		mdl_file.read((char *) vertices.data(), vertex_count * sizeof(nge::graphics::VertexFormat));
-
-		// read corner indices
-		u32 vertex_index_count;
-		mdl_file.read((char *) &vertex_index_count, sizeof(u32));
-		assert(vertex_index_count < 10000); // sanity check
-		std::vector<u16> vertex_indices;
-		vertex_indices.resize(vertex_index_count);
-		mdl_file.read((char *) vertex_indices.data(), vertex_index_count * sizeof(u16));
-
-		return {vertices, vertex_indices};
+		NGE_PROFILE_SCOPE("Planet loop");
+
+		// only the planets in view are drawn
+		planet_bounds.Clear();
+		for (const auto& planet: world.planets)
+			planet_bounds.Add(planet.center, planet.radius);
+		planet_bounds.Cull(frustum, visible_planets);
+
+		// render all objects, the instances pick their maps from the material arrays so all planets using the same
+		// level of detail are a single draw, planets of a few pixels are ray-traced on quads instead
+		for (auto& level_instances : planet_instances)
+			level_instances.clear();
+		planet_impostor_instances.clear();
+		for (const u32 index : visible_planets)
+		{
+			const auto& planet = world.planets[index];
+			PlanetDrawState& draw_state = planet_draw_states[planet.id];
+			// in pixels of the scene, so that planets lose detail along with the resolution
+			const float screen_radius = nge::graphics::IcosphereLodChain::ComputeScreenRadius(planet.center, planet.radius,
+				camera.Position, projection[1][1], static_cast<float>(scene_target.GetRenderSize().height));
+			draw_state.is_impostor = nge::graphics::SphereImpostors::ShouldUseImpostor(screen_radius, draw_state.is_impostor);
+			if (draw_state.is_impostor)
+			{
+				planet_impostor_instances.push_back(planet.instance);
+			}
+			else
+			{
+				draw_state.lod_level = planet_lods.SelectLevel(screen_radius, draw_state.lod_level);
+				planet_instances[draw_state.lod_level].push_back(planet.instance);
+			}
+		}
+
+		for (u32 level = 0; level < nge::graphics::IcosphereLodChain::LEVEL_COUNT; level++)
+			SubmitPlanets(planet_instances[level], planet_lods.GetLevel(level), planet_shader);
+		SubmitPlanets(planet_impostor_instances, planet_impostors, impostor_shader);
 	}
 
 public:
-	NeutronGame():
+	NeutronGame(const nge::Extent2D& viewport, const Settings& settings):
 		needs_to_stop(false),
 		camera(nge::math::Vector3(50.0f, 0.0f, 50.0f)),
 		firstMouse(true),
@@ -127,28 +313,91 @@ public:
 		stop(false),
 		stopTimeout(0.0f),
 		planets(),
-		skybox_shader("shaders/skybox.vs", "shaders/skybox.fs"),
-		particle_shader("shaders/particle.vs", "shaders/particle.fs"),
-		planet_shader("shaders/shader.vs", "shaders/shader.fs"),
-		planet_model(CreateModelFromFile("models/sphere.mdl")),
+		debris(),
+		program_cache(PROGRAM_CACHE_DIRECTORY),
+		skybox_shader("shaders/skybox.vs", "shaders/skybox.fs", &program_cache),
+		particle_shader("shaders/particle.vs", "shaders/particle.fs", &program_cache),
+		planet_shader("shaders/shader.vs", "shaders/shader.fs", GetLightingHeader(), &program_cache),
+		impostor_shader("shaders/impostor.vs", "shaders/impostor.fs", GetLightingHeader(), &program_cache),
+		use_gpu_particles(settings.use_gpu_particles),
+		particle_update_shader(),
+		gpu_particle_shader(),
+		streaming_buffer(STREAMING_BUFFER_CAPACITY),
+		planet_lods(),
+		planet_impostors(),
+		planet_materials(),
+		planet_draw_states(),
+		planet_bounds(),
+		visible_planets(),
+		planet_instances(),
+		planet_impostor_instances(),
+		light_clusters(),
+		light_cluster_buffers(),
+		render_queue(),
+		viewport(viewport),
+		scene_target(viewport),
+		gpu_frame_timer(),
+		resolution_scaler(),
 		sun(SUN_MASS, 5, 0, 0, 0, 0, 0, 0, planet_shader, Planet::Type::Sun),
 		mercury(90, .5, 1.5, -30, 0, 0.0004, 0.00015, 0, planet_shader, Planet::Type::Mercury),
 		earth(100, 1, 50, 0, 0, 0.0001, 0.0003, 0, planet_shader, Planet::Type::Earth),
 		moon(1, .2, 51.5, -1.5, 0, 0.0001, 0.0003 + 0.00008, 0, planet_shader, Planet::Type::Moon),
-		mars(60, .8, 1.5, -80, 0, -0.0005, 0.00004, 0, planet_shader, Planet::Type::Mars)
+		mars(60, .8, 1.5, -80, 0, -0.0005, 0.00004, 0, planet_shader, Planet::Type::Mars),
+		simulation([this](const std::span<const nge::timing::Seconds> frame_times, WorldSnapshot& snapshot)
+			{Simulate(frame_times, snapshot);})
 	{
+		// the impostors sample the same maps as the planet models
+		impostor_shader.Use();
+		impostor_shader.SetUniform(impostor_shader.GetUniform("material.diffuse"), 0);
+		impostor_shader.SetUniform(impostor_shader.GetUniform("material.normal"), 1);
+		impostor_shader.SetUniform(impostor_shader.GetUniform("material.specular"), 2);
+		nge::graphics::LightClusterBuffers::SetSamplers(planet_shader);
+		nge::graphics::LightClusterBuffers::SetSamplers(impostor_shader);
+
+		if (settings.frame_budget)
+			resolution_scaler.emplace(*settings.frame_budget);
+
 		makeSkybox(skybox_shader);
-		makeParticles(particle_shader);
+		if (use_gpu_particles)
+		{
+			particle_update_shader.emplace("shaders/particle_update.vs",
+				std::span(nge::graphics::GpuParticleSystem::UPDATE_VARYINGS), &program_cache);
+			gpu_particle_shader.emplace("shaders/particle_gpu.vs", "shaders/particle.fs", &program_cache);
+			makeGpuParticles(*particle_update_shader, *gpu_particle_shader);
+		}
+		else
+		{
+			makeParticles(particle_shader);
+		}
 
 		planets.emplace_back(sun);
 		planets.emplace_back(mercury);
 		planets.emplace_back(earth);
 		planets.emplace_back(moon);
 		planets.emplace_back(mars);
+		for (u32 i = 0; i < planets.size(); i++)
+			planets[i].id = i;
+		// planets only ever merge, so no id is ever added
+		planet_draw_states.resize(planets.size());
+
+		// debris is spread between the sun and beyond mars, the closest circling the fastest
+		nge::random::Stream random(DEBRIS_SEED);
+		for (u32 i = 0; i < settings.debris_count; i++)
+		{
+			const float orbit_radius = random.NextUniform(8.0f, 90.0f);
+			debris.push_back({orbit_radius, random.NextUniform(0.0f, 2.0f * glm::pi<float>()),
+				random.NextUniform(1.0f, 3.0f) / orbit_radius, random.NextUniform(-2.0f, 2.0f),
+				nge::math::Vector3(random.NextUniform(0.2f, 1.0f), random.NextUniform(0.2f, 1.0f), random.NextUniform(0.2f, 1.0f))});
+		}
+
+		simulation.Start();
 	}
 
 	bool Tick(const float delta_time)
 	{
+		NGE_PROFILE_SCOPE("NeutronGame::Tick");
+		NGE_PROFILE_GPU_FRAME();
+
 		// process pending keyboard input
 		if (w_key_pressed)
 			camera.ProcessKeyboard(FORWARD, delta_time);
@@ -167,128 +416,96 @@ public:
 		if (stopTimeout > 0.f)
 			stopTimeout -= delta_time;
 
-		// steps gravity and movement with physics, and do collision detection + handling
-		Step(delta_time);
+		// the world simulated during the previous frame is drawn while the simulation thread steps the next one
+		const WorldSnapshot& world = simulation.GetLatest();
+		simulation.Advance(stop ? 0.0f : delta_time);
+
+		// the GPU time of an earlier frame sets the resolution of this one
+		const auto gpu_frame_time = gpu_frame_timer.BeginFrame();
+		if (resolution_scaler && gpu_frame_time)
+			scene_target.SetScale(resolution_scaler->Update(*gpu_frame_time));
+		scene_target.Begin();
 
 		// we don't need to clear GL_COLOR_BUFFER_BIT due to the skybox being in the background
 		glClear(GL_DEPTH_BUFFER_BIT);
 
-		// shader properties for all planets and the sun
-		planet_shader.use();
-		planet_shader.setVec3("light.position", 0.f, 0.f, 0.f);
-		planet_shader.setVec3("viewPos", camera.Position);
-		// full on sunlight - will be reduced after the sun is drawn
-		planet_shader.setVec3("light.ambient", .8f, .8f, .8f);
-		planet_shader.setVec3("light.diffuse", .7f, .7f, .7f);
-		planet_shader.setVec3("light.specular", .5f, .5f, .5f);
-
 		// view and projection matrix, with a depth sufficient so it doesn't crop objects - both are also multiplied here in advanced for optimisation
 		const nge::math::Matrix4& view = camera.GetViewMatrix();
-		const nge::math::Matrix4 projection = glm::perspective(glm::radians(camera.Zoom), (float) 1600 / (float) 1000, 0.1f, 1024.0f);
+		const float aspect_ratio = static_cast<float>(viewport.width) / static_cast<float>(viewport.height);
+		const nge::math::Matrix4 projection = glm::perspective(glm::radians(camera.Zoom), aspect_ratio, NEAR_PLANE, FAR_PLANE);
 		const nge::math::Matrix4 viewProj = projection * view;
 
-		glDepthFunc(GL_LEQUAL);
-		glEnable(GL_DEPTH_TEST);
-
-		// render all objects (model is calculated in the draw function itself)
-		planet_shader.setMat4("view_projection_matrix", viewProj);
-		planet_model.Set(); // TODO: encapsulate inside a PlanetRenderer class
-		for (auto& planet: planets)
-		{
-			planet.SetShaderVariables(planet_shader, stop ? 0.0f : delta_time);
-			planet_model.Draw();
+		// the point lights reaching each cluster of the view, which the planet programs loop over
+		light_clusters.Build(world.lights, view, projection, NEAR_PLANE, FAR_PLANE);
 
-			// only the sun needs to be super bright, and its drawn first
-			planet_shader.setVec3("light.ambient", .1f, .1f, .1f);
-		}
-		planet_model.Unset(); // TODO: encapsulate inside a PlanetRenderer class
+		// the frame's region of the streaming buffer, free once the GPU is done with the frame that used it last
+		streaming_buffer.BeginFrame();
+		light_cluster_buffers.Upload(light_clusters, streaming_buffer);
 
-		drawSkybox(skybox_shader, view, projection);
-
-		// draw particles
-		particle_shader.use();
-		particle_shader.setMat4("view_projection_matrix", viewProj);
-		glDisable(GL_DEPTH_TEST);
-		drawParticles(particle_shader, stop ? 0.0f : delta_time);
-		glEnable(GL_DEPTH_TEST);
+		// uniforms shared by every program, written once for the whole frame
+		streaming_buffer.WriteUniforms(nge::graphics::FRAME_UNIFORMS_BINDING, nge::graphics::FrameUniforms
+		{
+			viewProj,
+			nge::math::Vector4(camera.Position, 1.f),
+			nge::math::Vector4(0.f, 0.f, 0.f, 1.f), // the sun, the glowing debris are clustered point lights
+			nge::math::Vector4(.7f, .7f, .7f, 0.f),
+			nge::math::Vector4(.5f, .5f, .5f, 0.f),
+			nge::math::Vector4(NEAR_PLANE, light_clusters.GetSlicesPerLogDepth(), 0.f, 0.f)
+		});
+
+		const auto frustum = nge::graphics::Frustum::FromViewProjection(viewProj);
+
+		render_queue.Clear();
+		SubmitVisiblePlanets(world, frustum, projection);
+		submitSkybox(skybox_shader, render_queue);
+		if (use_gpu_particles)
+			submitGpuParticles(*gpu_particle_shader, stop ? 0.0f : delta_time, render_queue);
+		else
+			submitParticles(particle_shader, world.particles, frustum, render_queue, streaming_buffer);
+		streaming_buffer.Flush();
+		render_queue.Execute();
+		scene_target.End();
+		gpu_frame_timer.EndFrame();
+		streaming_buffer.EndFrame();
 
 		return true;
 	}
 
-	void Step(const nge::timing::Seconds time)
+	// runs on the simulation thread, every planet keeps rotating even when out of view
+	// each frame is stepped on its own, so that the world moves the same whether or not the simulation fell behind
+	void Simulate(const std::span<const nge::timing::Seconds> frame_times, WorldSnapshot& snapshot)
 	{
-		if (stop)
-			return;
-
-		// gravitational constant
-		constexpr float GRAVITATIONAL = 6.674 / 100000000000;
-		// apply gravity
-		// auto is Planet, bool, where the bool states if the objects are active -
-		// they get turned off when they have collided with the sun, in which case they are to be ignored
-		for (auto& planet_a: planets)
+		NGE_PROFILE_SCOPE("NeutronGame::Simulate");
+		// steps gravity and movement with physics, and do collision detection + handling
+		for (const nge::timing::Seconds time : frame_times)
+			Step(time);
+
+		snapshot.planets.clear();
+		for (const auto& planet : planets)
+			snapshot.planets.push_back({planet.id, nge::math::Vector3(planet.x, planet.y, planet.z), planet.radius,
+				planet.ComputeInstance()});
+		if (!use_gpu_particles)
+			simulateParticles(frame_times, snapshot.particles);
+
+		snapshot.lights.clear();
+		for (auto& piece : debris)
 		{
-			// all objects get pull from other objects - except themselves and disabled objects
-			for (const auto& planet_b : planets)
-			{
-				// the sun and other bigger objects wont be affected by the earth and the earth wont be by the moon or by other same weight planets - for simplicity, and optimisation
-				if (planet_b.mass <= planet_a.mass)
-					continue;
-				double distance = planet_a.DistanceFrom(planet_b);
-				// hack: the earth should have a pull much stronger on the moon, because its supposed to be much closer (but we wouldn't see anything if it was real scale)
-				if (planet_a.mass * planet_b.mass == EARTH_MOON_MASS)
-					distance /= 100;
-
-				const float pull = planet_b.mass * GRAVITATIONAL / (distance * distance) * time;
-				planet_a.vX += pull * ((planet_b.x > planet_a.x) ? 1 : -1);
-				planet_a.vY += pull * ((planet_b.y > planet_a.y) ? 1 : -1);
-				planet_a.vZ += pull * ((planet_b.z > planet_a.z) ? 1 : -1);
-			}
+			for (const nge::timing::Seconds time : frame_times)
+				piece.angle = std::fmod(piece.angle + piece.angular_speed * time, 2.0f * glm::pi<float>());
+			snapshot.lights.push_back({nge::math::Vector3(std::cos(piece.angle) * piece.orbit_radius,
+				std::sin(piece.angle) * piece.orbit_radius, piece.height), DEBRIS_LIGHT_RADIUS, piece.color});
 		}
+	}
 
-		// check for collisions and handle them
-		for (auto& planet_a: planets)
-		{
-			for (auto& planet_b: planets)
-			{
-				if (&planet_a == &planet_b)
-					continue;
-
-				if (planet_a.DistanceFrom(planet_b) < (planet_a.radius + planet_b.radius))
-				{
-					// a collision with the sun is fatal
-//					if (planet_a.mass == SUN_MASS)
-//						objectList[planet_b] = false;
-//					else if (planet_b.mass == SUN_MASS)
-//						objectList[planet_a] = false;
-					// otherwise both objects move away
-//					else
-					{
-						// determine the strength of the collision
-						const double factor = planet_b.mass * planet_a.mass * std::sqrt(
-											(planet_a.vX - planet_b.vX) * (
-												planet_a.vX - planet_b.vX) +
-											(planet_a.vY - planet_b.vY) * (
-												planet_a.vY - planet_b.vY) +
-											(planet_a.vZ - planet_b.vZ) * (
-												planet_a.vZ - planet_b.vZ)
-										);
-						// make them move away from each other with the strength of the impact
-						planet_b.vX += factor / planet_b.mass * (planet_b.vX > 0 ? -1 : 1);
-						planet_b.vY += factor / planet_b.mass * (planet_b.vY > 0 ? -1 : 1);
-						planet_b.vZ += factor / planet_b.mass * (planet_b.vZ > 0 ? -1 : 1);
-						planet_a.vX += factor / planet_a.mass * (planet_a.vX > 0 ? -1 : 1);
-						planet_a.vY += factor / planet_a.mass * (planet_a.vY > 0 ? -1 : 1);
-						planet_a.vZ += factor / planet_a.mass * (planet_a.vZ > 0 ? -1 : 1);
-						// move them away enough so they're no longer in collision
-						planet_a.Tick(time);
-						planet_b.Tick(time);
-					}
-				}
-			}
-		}
+	// a time of zero is requested while time is stopped
+	void Step(const nge::timing::Seconds time)
+	{
+		NGE_PROFILE_SCOPE("NeutronGame::Step");
+		if (time <= 0.0f)
+			return;
 
-		// update all planets
+		StepOrbits(planets, time);
 		for (auto& planet : planets)
-			planet.Tick(time);
+			planet.Rotate();
 	}
 };
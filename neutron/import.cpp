@@ -5,7 +5,14 @@
 #include "particle_generator.hh"
 
 #include <glad/glad.h>
-#include <learnopengl/shader.h>
+
+// nge headers
+#include "nge_shader.hh"
+#include "nge_gpu_particles.hh"
+#include "nge_profiler.hh"
+
+// std headers
+#include <string>
 
 // nge headers
 #include "nge_math.hh"
@@ -59,12 +66,20 @@ unsigned int skyboxVAO, skyboxVBO;
 unsigned int cubemapTexture;
 
 ParticleGenerator* Particles;
+nge::graphics::GpuParticleSystem* GpuParticles;
+unsigned int gpuParticleTexture;
+
+// same particles either way, the GPU only ever keeps as many as the CPU
+constexpr unsigned int PARTICLE_COUNT = 200;
+constexpr unsigned int PARTICLES_PER_UPDATE = 4;
+// every run spawns the same particles
+constexpr u64 PARTICLE_SEED = 0x6E657574726F6E; // "neutron"
 
 void makeSkybox(const Shader& skyboxShader)
 {
 	glGenVertexArrays(1, &skyboxVAO);
 	glGenBuffers(1, &skyboxVBO);
-	glBindVertexArray(skyboxVAO);
+	StateCache::Current().BindVertexArray(skyboxVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
@@ -80,105 +95,143 @@ void makeSkybox(const Shader& skyboxShader)
 	};
 	cubemapTexture = loadCubemap(faces);
 
-	skyboxShader.use();
-	skyboxShader.setInt("skybox", 0);
+	skyboxShader.Use();
+	skyboxShader.SetUniform(skyboxShader.GetUniform("skybox"), 0);
 }
 
-void drawSkybox(const Shader& skyboxShader, const mat4& view, const mat4& projection)
+void submitSkybox(const Shader& skyboxShader, nge::graphics::RenderQueue& queue)
 {
-	skyboxShader.use();
-	skyboxShader.setMat4("view_projection_matrix", projection * view);
-	// skybox cube
-	glBindVertexArray(skyboxVAO);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	NGE_PROFILE_SCOPE("submitSkybox");
+	// the view and projection come from the per-frame uniforms
+	// skybox cube, at the far plane so it only passes the depth test where nothing was drawn
+	nge::graphics::DrawPacket packet;
+	packet.sort_key = nge::graphics::RenderQueue::MakeSortKey(nge::graphics::RenderLayer::Sky, skyboxShader.GetHandle(), cubemapTexture, 0.0f);
+	packet.program = skyboxShader.GetHandle();
+	packet.state.depth_func = GL_LEQUAL;
+	packet.vertex_array = skyboxVAO;
+	packet.AddTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
+	packet.vertex_count = 36;
+	queue.Submit(packet);
 }
 
 void makeParticles(const Shader& particleShader)
 {
-	particleShader.use();
-	particleShader.setInt("particle", 0);
+	particleShader.Use();
+	particleShader.SetUniform(particleShader.GetUniform("sprite"), 0);
 	// make 100 of them to start with
-	Particles = new ParticleGenerator(generateMipmappedTexture("textures/particles.png"), 200);
+	Particles = new ParticleGenerator(generateMipmappedTexture("textures/particles.png"), PARTICLE_COUNT, PARTICLE_SEED);
+}
+
+// the update and pack only touch the particles, and the submission only the render state, so both can run at once
+void simulateParticles(const std::span<const nge::timing::Seconds> frame_times, std::vector<ParticleInstance>& alive_instances)
+{
+	NGE_PROFILE_SCOPE("simulateParticles");
+	for (const nge::timing::Seconds delta_time : frame_times)
+	{
+		if (delta_time)
+			Particles->Update(delta_time, PARTICLES_PER_UPDATE);
+	}
+	Particles->Pack(alive_instances);
 }
 
-void drawParticles(const Shader& particleShader, const nge::timing::Seconds delta_time)
+void submitParticles(const Shader& particleShader, std::span<const ParticleInstance> alive_instances, const nge::graphics::Frustum& frustum, nge::graphics::RenderQueue& queue, nge::graphics::StreamingBuffer& streaming_buffer)
 {
-	if (delta_time)
-		Particles->Update(delta_time, 4);
-	Particles->Draw(particleShader);
+	NGE_PROFILE_SCOPE("submitParticles");
+	Particles->Submit(particleShader, alive_instances, frustum, queue, streaming_buffer);
 }
 
-// Planet (part that would be common to multiple space objects first)
-void Planet::Tick(double time)
+void makeGpuParticles(const Shader& updateShader, const Shader& drawShader)
 {
-	x += vX;
-	y += vY;
-	z += vZ;
+	drawShader.Use();
+	drawShader.SetUniform(drawShader.GetUniform("sprite"), 0);
+	gpuParticleTexture = generateMipmappedTexture("textures/particles.png");
+	GpuParticles = new nge::graphics::GpuParticleSystem(PARTICLE_COUNT, updateShader, static_cast<u32>(PARTICLE_SEED));
 }
 
-float Planet::DistanceFrom(const Planet& object) const
+// the particles never leave the GPU, so they are neither culled nor sorted, dead ones are simply not rasterized
+void submitGpuParticles(const Shader& drawShader, const nge::timing::Seconds delta_time, nge::graphics::RenderQueue& queue)
 {
-	return std::sqrt(
-		std::fabs( // TODO: does this actually do anything?
-			(object.x - x) * (object.x - x) +
-			(object.y - y) * (object.y - y) +
-			(object.z - z) * (object.z - z)
-		)
-	);
+	NGE_PROFILE_SCOPE("submitGpuParticles");
+	GpuParticles->Update(delta_time, PARTICLES_PER_UPDATE, glm::vec3(-5.0f, -5.0f, -5.0f));
+
+	// same state as the CPU particles
+	nge::graphics::DrawPacket packet = GpuParticles->MakeDrawPacket();
+	packet.sort_key = nge::graphics::RenderQueue::MakeSortKey(nge::graphics::RenderLayer::Overlay, drawShader.GetHandle(), gpuParticleTexture, 0.0f);
+	packet.program = drawShader.GetHandle();
+	packet.state.depth_test = false;
+	packet.state.cull_face = false;
+	packet.state.blend_source_factor = GL_SRC_ALPHA;
+	packet.state.blend_destination_factor = GL_ONE;
+	packet.AddTexture(0, GL_TEXTURE_2D, gpuParticleTexture);
+	queue.Submit(packet);
 }
 
-Planet::Planet(int mass, float radius, double posX, double posY, double posZ, double speedX, double speedY,
-               double speedZ, Shader& planetShader, Type type) : mass(mass), radius(radius), x(posX), y(posY), z(posZ),
-                                                                 vX(speedX), vY(speedY), vZ(speedZ)
+PlanetMaterials::PlanetMaterials():
+	diffuse_maps(MAP_WIDTH, MAP_HEIGHT, Planet::TYPE_COUNT),
+	normal_maps(MAP_WIDTH, MAP_HEIGHT, Planet::TYPE_COUNT),
+	specular_maps(MAP_WIDTH, MAP_HEIGHT, Planet::TYPE_COUNT)
 {
-	std::string textureFile;
-	std::string name;
-	switch (type)
+	for (u32 layer = 0; layer < Planet::TYPE_COUNT; layer++)
 	{
-	case Type::Sun:
-		textureFile = "textures/planets/sun/";
-		name = "sun.png";
-		break;
-	case Type::Moon:
-		textureFile = "textures/planets/moon/";
-		name = "moon.jpg";
-		break;
-	case Type::Mercury:
-		textureFile = "textures/planets/mercury/";
-		name = "mercury.png";
-		break;
-	case Type::Mars:
-		textureFile = "textures/planets/mars/";
-		name = "mars.jpg";
-		break;
-	case Type::Earth:
-	default:
-		textureFile = "textures/planets/earth/";
-		name = "earth.jpg";
-		break;
+		std::string textureFile;
+		std::string name;
+		switch (static_cast<Planet::Type>(layer))
+		{
+		case Planet::Type::Sun:
+			textureFile = "textures/planets/sun/";
+			name = "sun.png";
+			break;
+		case Planet::Type::Moon:
+			textureFile = "textures/planets/moon/";
+			name = "moon.jpg";
+			break;
+		case Planet::Type::Mercury:
+			textureFile = "textures/planets/mercury/";
+			name = "mercury.png";
+			break;
+		case Planet::Type::Mars:
+			textureFile = "textures/planets/mars/";
+			name = "mars.jpg";
+			break;
+		case Planet::Type::Earth:
+		default:
+			textureFile = "textures/planets/earth/";
+			name = "earth.jpg";
+			break;
+		}
+		diffuse_maps.SetLayer(layer, loadImage(textureFile + name));
+		normal_maps.SetLayer(layer, loadImage(textureFile + "norm.png"));
+		specular_maps.SetLayer(layer, loadImage(textureFile + "spec.png"));
 	}
-	planetTextureID = generateMipmappedTexture(textureFile + name);
-	normalMapID = generateMipmappedTexture(textureFile + "norm.png");
-	specMapID = generateMipmappedTexture(textureFile + "spec.png");
-
-	planetShader.use();
-	//planetShader.setInt(texture, 0);
-	planetShader.setInt("material.diffuse", 0);
-	planetShader.setInt("material.normal", 1);
-	planetShader.setInt("material.specular", 2);
+	diffuse_maps.GenerateMipmaps();
+	normal_maps.GenerateMipmaps();
+	specular_maps.GenerateMipmaps();
+}
+
+void PlanetMaterials::AddTextures(nge::graphics::DrawPacket& packet) const
+{
+	packet.AddTexture(0, GL_TEXTURE_2D_ARRAY, diffuse_maps.GetHandle());
+	packet.AddTexture(1, GL_TEXTURE_2D_ARRAY, normal_maps.GetHandle());
+	packet.AddTexture(2, GL_TEXTURE_2D_ARRAY, specular_maps.GetHandle());
+}
+
+Planet::Planet(int mass, float radius, double posX, double posY, double posZ, double speedX, double speedY,
+               double speedZ, Shader& planetShader, Type type) : OrbitalBody{mass, radius, posX, posY, posZ, speedX, speedY, speedZ},
+                                                                 type(type)
+{
+	planetShader.Use();
+	planetShader.SetUniform(planetShader.GetUniform("material.diffuse"), 0);
+	planetShader.SetUniform(planetShader.GetUniform("material.normal"), 1);
+	planetShader.SetUniform(planetShader.GetUniform("material.specular"), 2);
 };
 
-void Planet::SetShaderVariables(const Shader& planetShader, const nge::timing::Seconds time)
+void Planet::Rotate()
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, planetTextureID);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, normalMapID);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, specMapID);
+	rotation += vec3(this->vX / 2.f, this->vY / 2.f, this->vZ / 2.f);
+}
 
+nge::graphics::InstanceFormat Planet::ComputeInstance() const
+{
 	// identity matrix
 	mat4 model = mat4(1.0f);
 
@@ -190,10 +243,11 @@ void Planet::SetShaderVariables(const Shader& planetShader, const nge::timing::S
 	model = translate(model, vec3(this->x, this->y, this->z));
 	model = scale(model, vec3(radius));
 
-	if (time)
-		rotation += vec3(this->vX / 2.f, this->vY / 2.f, this->vZ / 2.f);
 	model = rotate(model, rotation.x, vec3(1.f, 0.f, 0.f));
 	model = rotate(model, rotation.y, vec3(0.f, 1.f, 0.f));
 	model = rotate(model, rotation.z, vec3(0.f, 0.f, 1.f));
-	planetShader.setMat4("model_to_world_matrix", model);
+
+	// only the sun needs to be super bright
+	const float ambient = type == Type::Sun ? .8f : .1f;
+	return {model, static_cast<u32>(type), ambient};
 }
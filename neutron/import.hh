@@ -5,19 +5,50 @@
 
 // nge headers
 #include "nge_timing.hh"
+#include "nge_graphics.hh"
+#include "nge_texture.hh"
+#include "nge_culling.hh"
+#include "nge_render_queue.hh"
+#include "nge_streaming.hh"
+#include "nge_math.hh"
+
+// game headers
+#include "orbits.hh"
+
+// std headers
+#include <vector>
+#include <span>
 
 // This file creates and then manages objects, with the help of particle_generator.h in the case of particles, and planet.h to generate spheres.
 // texure.h is also used to import textures.
 
-class Shader;
+namespace nge::graphics
+{
+	class Shader;
+}
+using nge::graphics::Shader;
+using nge::graphics::StateCache;
+
 // Skybox management.
 void makeSkybox(const Shader &skyboxShader);
-void drawSkybox(const Shader &skyboxShader, const glm::mat4 &view, const glm::mat4 &projection);
+void submitSkybox(const Shader &skyboxShader, nge::graphics::RenderQueue& queue);
+// Per-instance data of a particle, streamed to the GPU every frame
+struct ParticleInstance
+{
+	nge::math::Vector4 position_and_scale; // xyz is the position, w the scale
+	nge::math::Vector4 color;
+};
+
 // Particles management.
 void makeParticles(const Shader &particleShader);
-void drawParticles(const Shader &particleShader, const nge::timing::Seconds deltaTime);
+// Updates the particles once per frame (on the simulation thread) and packs the alive ones to be drawn.
+void simulateParticles(std::span<const nge::timing::Seconds> frameTimes, std::vector<ParticleInstance>& aliveInstances);
+void submitParticles(const Shader &particleShader, std::span<const ParticleInstance> aliveInstances, const nge::graphics::Frustum& frustum, nge::graphics::RenderQueue& queue, nge::graphics::StreamingBuffer& streamingBuffer);
+// Particles simulated on the GPU instead, updated and submitted on the render thread.
+void makeGpuParticles(const Shader &updateShader, const Shader &drawShader);
+void submitGpuParticles(const Shader &drawShader, const nge::timing::Seconds deltaTime, nge::graphics::RenderQueue& queue);
 
-class Planet {
+class Planet : public OrbitalBody {
 public:
 	// For each planet, that have corresponding textures.
 	enum class Type
@@ -28,24 +59,37 @@ public:
 		Mars,
 		Mercury,
 	};
+	static constexpr u32 TYPE_COUNT = 5;
 
 	Planet(int mass, float radius, double posX, double posY, double posZ, double speedX, double speedY, double speedZ, Shader& planetShader, Type type);
 
-	void Tick(double time);
-	float DistanceFrom(const Planet& object) const;
 	void makePlanet(const Shader& planetShader, Type type);
-	void SetShaderVariables(const Shader& planetShader, const nge::timing::Seconds time);
+	// turns the planet by a step of its spin, which follows its speed
+	void Rotate();
+	// returns the data needed to draw this planet as one instance of the sphere model
+	nge::graphics::InstanceFormat ComputeInstance() const;
 
 public:
-	int mass = 100;
-	float radius = 1.f;
-	double x;
-	double y;
-	double z;
-	double vX;
-	double vY;
-	double vZ;
+	Type type;
 	glm::vec3 rotation = {0.f, 0.f, 0.f};
+	// identifies the planet across merges, for the state the render thread keeps about it
+	u32 id = 0;
+};
+
+// maps of every planet type, one texture array layer per type so that all planets are drawn without rebinding
+// the instances select their layer through their material index
+class PlanetMaterials {
+	nge::graphics::TextureArray diffuse_maps, normal_maps, specular_maps;
+
+public:
+	// every map is resampled to this size when cooking the arrays
+	static constexpr u32 MAP_WIDTH = 2048;
+	static constexpr u32 MAP_HEIGHT = 1024;
+
+	PlanetMaterials();
 
-	GLuint planetTextureID, normalMapID, specMapID;
+	// binds the arrays to the units of the planet shader samplers when drawing the packet
+	void AddTextures(nge::graphics::DrawPacket& packet) const;
+	// identifies the materials in sort keys
+	u32 GetMaterialID() const {return diffuse_maps.GetHandle();}
 };
@@ -1,13 +1,104 @@
 // engine headers
 #include "nge_window.hh"
+#include "nge_profiler.hh"
+#include "nge_frame_pacing.hh"
+#include "nge_state_cache.hh"
+#if defined(__linux__)
+#include "nge_headless.hh"
+#endif
 
 // game headers
 #include "game.hh"
 
-static void GuardedMain()
+// std headers
+#include <string_view>
+#include <string>
+#include <optional>
+#include <chrono>
+
+static constexpr const char* USAGE =
+	"usage: neutron [--trace <file.json>] [--gpu-particles] [--lights <count>] [--frame-budget <milliseconds>] [--low-latency [--just-in-time]] [--headless <frame count> [--dump <directory>] [--dump-interval <frames>]]";
+
+struct Options
+{
+	// profile the whole run and save it there, for chrome://tracing or ui.perfetto.dev
+	std::optional<std::string_view> trace_path;
+	// render that many frames offscreen as fast as possible, then quit
+	std::optional<u32> headless_frame_count;
+	// save every dump_interval-th headless frame in that directory
+	std::optional<std::string_view> dump_directory;
+	u32 dump_interval = 1;
+	// the game settings, except for the frame budget which depends on the window
+	NeutronGame::Settings settings;
+	// GPU time per frame which the render resolution adapts to, 0 to always render at the window resolution
+	std::optional<float> frame_budget_milliseconds;
+	// poll input right before each frame instead of after presenting the previous one, and wait for the previous frame
+	// to be presented before starting the next
+	bool low_latency = false;
+	// also delay each frame so that it is ready just before vsync
+	bool just_in_time = false;
+};
+
+// budget of windowed runs, leaving some of a 60 Hz frame to the driver and the compositor
+static constexpr float DEFAULT_FRAME_BUDGET_MILLISECONDS = 14.0f;
+
+static Options ParseOptions(const int argc, char** argv)
 {
-	const nge::Window window("Neutron", nge::Extent2D(1600, 1000));
-	NeutronGame game;
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view argument = argv[i];
+		if (argument == "--trace" && i + 1 < argc)
+		{
+#if SHIPPING_BUILD
+			// the profiler is compiled out, so there would be nothing to save
+			throw std::runtime_error("Profiling is compiled out of shipping builds, --trace needs a debug build");
+#else
+			options.trace_path = argv[++i];
+#endif
+		}
+		else if (argument == "--headless" && i + 1 < argc)
+			options.headless_frame_count = static_cast<u32>(std::stoul(argv[++i]));
+		else if (argument == "--dump" && i + 1 < argc)
+			options.dump_directory = argv[++i];
+		else if (argument == "--dump-interval" && i + 1 < argc)
+			options.dump_interval = static_cast<u32>(std::stoul(argv[++i]));
+		else if (argument == "--gpu-particles")
+			options.settings.use_gpu_particles = true;
+		else if (argument == "--lights" && i + 1 < argc)
+			options.settings.debris_count = static_cast<u32>(std::stoul(argv[++i]));
+		else if (argument == "--frame-budget" && i + 1 < argc)
+			options.frame_budget_milliseconds = std::stof(argv[++i]);
+		else if (argument == "--low-latency")
+			options.low_latency = true;
+		else if (argument == "--just-in-time")
+			options.just_in_time = true;
+		else
+			throw std::runtime_error("Unknown argument " + std::string(argument) + ", " + USAGE);
+	}
+	if (options.headless_frame_count && *options.headless_frame_count == 0)
+		throw std::runtime_error(std::string("Headless runs need at least one frame, ") + USAGE);
+	if (options.dump_directory && !options.headless_frame_count)
+		throw std::runtime_error(std::string("Frames can only be dumped in headless mode, ") + USAGE);
+	if (options.just_in_time && !options.low_latency)
+		throw std::runtime_error(std::string("Frames can only be just in time in low latency mode, ") + USAGE);
+	return options;
+}
+
+struct RunStatistics
+{
+	u32 frame_count;
+	double seconds; // from the first frame to the end of the last one on the GPU
+};
+
+// runs the game in the given window until either wants to quit
+template<typename WindowType>
+static RunStatistics Run(WindowType& window, const Options& options, const float frame_budget_milliseconds)
+{
+	NeutronGame::Settings settings = options.settings;
+	if (frame_budget_milliseconds > 0.0f)
+		settings.frame_budget = frame_budget_milliseconds / 1000.0f;
+	NeutronGame game(window.GetViewport(), settings);
 	window.SetEventListener(&game);
 
 #if 0
@@ -22,28 +113,99 @@ static void GuardedMain()
 			<< std::endl;
 #endif
 
+#if !SHIPPING_BUILD
+	if (options.trace_path)
+		nge::profiling::Profiler::Get().StartCapture();
+#endif
+
 	//glfwSwapInterval(0); // to remove the 60 fps limit
-	float time = 0.0f;
-	float last_time = 0.0f;
+	// the driver queues a few frames otherwise, each adding a frame of latency
+	nge::FramePacer frame_pacer({options.low_latency ? 1u : 0u, options.just_in_time});
+	u32 frame_count = 0;
+	// loading binds everything once, only the state changes of frames are counted
+	nge::graphics::StateCache::Current().ResetStatistics();
+	const auto start_time = std::chrono::steady_clock::now();
+	auto last_time = start_time;
 	while (!window.ShouldClose())
 	{
-		time = static_cast<float>(glfwGetTime());
-		const float delta_time = time - last_time;
+		frame_pacer.BeginFrame();
+		if (options.low_latency)
+		{
+			window.ProcessEvents();
+			frame_pacer.OnInputPolled();
+		}
+
+		const auto time = std::chrono::steady_clock::now();
+		const float delta_time = std::chrono::duration<float>(time - last_time).count();
 		last_time = time;
 
 		if (!game.Tick(delta_time))
 			break; // we want to quit
 
+		frame_pacer.OnFrameReady();
 		window.Present();
-		window.ProcessEvents();
+		frame_pacer.OnFramePresented();
+		if (!options.low_latency)
+		{
+			window.ProcessEvents();
+			frame_pacer.OnInputPolled();
+		}
+		frame_count++;
+	}
+	glFinish();
+	const RunStatistics statistics{frame_count, std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count()};
+
+	const nge::LatencyReport latency = frame_pacer.GetLatencyReport();
+	if (latency.sample_count > 0)
+		std::cout << "Input to swap completion latency of " << latency.sample_count << " frames: " << latency.median * 1000.0f
+			<< " ms median, " << latency.percentile_90 * 1000.0f << " ms 90th percentile, " << latency.percentile_99 * 1000.0f
+			<< " ms 99th percentile, " << latency.max * 1000.0f << " ms max\n";
+	const auto& state_statistics = nge::graphics::StateCache::Current().GetStatistics();
+	if (frame_count > 0)
+		std::cout << "State changes per frame: " << state_statistics.issued_calls / frame_count << " issued, "
+			<< state_statistics.filtered_calls / frame_count << " redundant ones filtered out\n";
+
+#if !SHIPPING_BUILD
+	if (options.trace_path)
+	{
+		auto& profiler = nge::profiling::Profiler::Get();
+		profiler.StopCapture();
+		const usize event_count = profiler.ExportChromeTrace(*options.trace_path);
+		std::cout << "Saved " << event_count << " profiled events to " << *options.trace_path << '\n';
+	}
+#endif
+	return statistics;
+}
+
+static void GuardedMain(const Options& options)
+{
+	NGE_PROFILE_THREAD("Render");
+	const nge::Extent2D dimensions(1600, 1000);
+	if (!options.headless_frame_count)
+	{
+		nge::Window window("Neutron", dimensions);
+		Run(window, options, options.frame_budget_milliseconds.value_or(DEFAULT_FRAME_BUDGET_MILLISECONDS));
+		return;
 	}
+
+#if defined(__linux__)
+	nge::HeadlessWindow window(dimensions, *options.headless_frame_count,
+		options.dump_directory ? std::optional<std::filesystem::path>(*options.dump_directory) : std::nullopt,
+		options.dump_interval);
+	// benchmarks measure a fixed amount of work, so the resolution only adapts when asked to
+	const auto [frame_count, seconds] = Run(window, options, options.frame_budget_milliseconds.value_or(0.0f));
+	std::cout << "Rendered " << frame_count << " frames in " << seconds << " s, " << seconds * 1000.0 / frame_count
+		<< " ms per frame (" << frame_count / seconds << " fps)\n";
+#else
+	throw std::runtime_error("Headless rendering needs EGL, which is only supported on Linux.");
+#endif
 }
 
 int main(int argc, char** argv)
 {
 	try
 	{
-		GuardedMain();
+		GuardedMain(ParseOptions(argc, argv));
 	}
 	catch (const std::exception& x)
 	{
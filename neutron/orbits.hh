@@ -0,0 +1,120 @@
+#pragma once
+
+// nge headers
+#include "nge_timing.hh"
+#include "types.hh"
+
+// std headers
+#include <vector>
+#include <cmath>
+#include <utility>
+
+// This file moves the planets: gravity, collisions and movement, kept apart from how they are drawn so that it can run and
+// be tested without any graphics.
+
+// position, speed and size of a planet
+struct OrbitalBody
+{
+	int mass = 100;
+	float radius = 1.f;
+	double x;
+	double y;
+	double z;
+	double vX;
+	double vY;
+	double vZ;
+
+	void Tick(double time)
+	{
+		x += vX;
+		y += vY;
+		z += vZ;
+	}
+
+	float DistanceFrom(const OrbitalBody& object) const
+	{
+		return std::sqrt(
+			std::fabs( // TODO: does this actually do anything?
+				(object.x - x) * (object.x - x) +
+				(object.y - y) * (object.y - y) +
+				(object.z - z) * (object.z - z)
+			)
+		);
+	}
+
+	// merges the other object into this one, conserving mass, momentum and volume
+	void Absorb(const OrbitalBody& object)
+	{
+		const double totalMass = mass + object.mass;
+		x = (x * mass + object.x * object.mass) / totalMass;
+		y = (y * mass + object.y * object.mass) / totalMass;
+		z = (z * mass + object.z * object.mass) / totalMass;
+		vX = (vX * mass + object.vX * object.mass) / totalMass;
+		vY = (vY * mass + object.vY * object.mass) / totalMass;
+		vZ = (vZ * mass + object.vZ * object.mass) / totalMass;
+		radius = std::cbrt(radius * radius * radius + object.radius * object.radius * object.radius);
+		mass += object.mass;
+	}
+};
+
+// masses of the earth and the moon multiplied, which is how their pair is recognized
+static constexpr u32 EARTH_MOON_MASS = 100;
+
+// applies gravity, merges the colliding bodies and moves them, a time of zero being requested while time is stopped
+// Body derives from OrbitalBody
+template<typename Body>
+void StepOrbits(std::vector<Body>& bodies, const nge::timing::Seconds time)
+{
+	if (time <= 0.0f)
+		return;
+
+	// gravitational constant
+	constexpr float GRAVITATIONAL = 6.674 / 100000000000;
+	// softening length, which keeps the pull finite when two bodies pass through each other before merging
+	constexpr double GRAVITATIONAL_SOFTENING = 0.1;
+	// apply gravity
+	for (auto& body_a: bodies)
+	{
+		// all objects get pull from other objects - except themselves and disabled objects
+		for (const auto& body_b : bodies)
+		{
+			// the sun and other bigger objects wont be affected by the earth and the earth wont be by the moon or by other same weight planets - for simplicity, and optimisation
+			if (body_b.mass <= body_a.mass)
+				continue;
+			const double distance = body_a.DistanceFrom(body_b);
+			// softened on the real distance, before the hack below shrinks it far below the softening length
+			double softened_distance_squared = distance * distance + GRAVITATIONAL_SOFTENING * GRAVITATIONAL_SOFTENING;
+			// hack: the earth should have a pull much stronger on the moon, because its supposed to be much closer (but we wouldn't see anything if it was real scale)
+			if (body_a.mass * body_b.mass == EARTH_MOON_MASS)
+				softened_distance_squared /= 100 * 100;
+
+			const float pull = body_b.mass * GRAVITATIONAL / softened_distance_squared * time;
+			body_a.vX += pull * ((body_b.x > body_a.x) ? 1 : -1);
+			body_a.vY += pull * ((body_b.y > body_a.y) ? 1 : -1);
+			body_a.vZ += pull * ((body_b.z > body_a.z) ? 1 : -1);
+		}
+	}
+
+	// colliding bodies merge, so the number of bodies to simulate and render only ever shrinks
+	for (usize a = 0; a < bodies.size(); a++)
+	{
+		for (usize b = a + 1; b < bodies.size();)
+		{
+			if (bodies[a].DistanceFrom(bodies[b]) >= bodies[a].radius + bodies[b].radius)
+			{
+				b++;
+				continue;
+			}
+
+			// the heavier body survives and keeps its slot, so the sun always stays first
+			if (bodies[b].mass > bodies[a].mass)
+				std::swap(bodies[a], bodies[b]);
+			bodies[a].Absorb(bodies[b]);
+			bodies.erase(bodies.begin() + b);
+		}
+	}
+
+	// update all bodies
+	for (auto& body : bodies)
+		body.Tick(time);
+}
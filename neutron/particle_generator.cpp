@@ -8,58 +8,96 @@
 ******************************************************************/
 #include "particle_generator.hh"
 #include "import.hh"
-#include <learnopengl/shader_m.h>
+#include "nge_shader.hh"
+
+// std headers
+#include <cmath>
 
 using namespace glm;
 using namespace std;
 
-ParticleGenerator::ParticleGenerator(GLuint texture, unsigned int amount)
-    : texture(texture), amount(amount)
+ParticleGenerator::ParticleGenerator(GLuint texture, unsigned int amount, u64 seed, u64 stream)
+    : particles(amount), random(seed, stream), texture(texture)
 {
     init();
 }
 
 void ParticleGenerator::Update(float delta, unsigned int newParticles, vec3 offset)
 {
+    // in a 10 unit cube from the offset, and up to 5 units per second on every axis
+    spawn_positions.resize(newParticles * 3);
+    spawn_velocities.resize(newParticles * 3);
+    random.FillUniform(spawn_positions, 0.0f, 10.0f);
+    random.FillUniform(spawn_velocities, -5.0f, 5.0f);
     for (unsigned int i = 0; i < newParticles; ++i) {
-        int unusedParticle = firstUnusedParticle();
-        respawnParticle(particles[unusedParticle], offset);
+        const vec3 position = offset + vec3(spawn_positions[i * 3], spawn_positions[i * 3 + 1], spawn_positions[i * 3 + 2]);
+        const vec3 velocity(spawn_velocities[i * 3], spawn_velocities[i * 3 + 1], spawn_velocities[i * 3 + 2]);
+        // dropped if all particles are alive (note that if it happens repeatedly, more particles should be reserved)
+        particles.Spawn(position, velocity, 1.0f);
     }
-    for (unsigned int i = 0; i < amount; ++i) {
-        Particle &p = particles[i];
-        p.life -= delta;
-        if (p.life > 0.0f)  { // move particle while alive
-            p.velocity *= (1 - delta);
-            p.position -= p.velocity * delta;
-            //p.color.x -= delta * 2.5f;
-        }
+    // the dead particles are removed on the way, the alive ones stay packed at the front
+    particles.Update(delta);
+}
+
+void ParticleGenerator::Pack(std::vector<ParticleInstance>& alive_instances) const
+{
+    alive_instances.clear();
+    for (u32 i = 0; i < particles.GetAliveCount(); ++i)
+    {
+        // make the size proportionate to the time left
+        const float scale = particles.GetLife(i) / 8;
+        alive_instances.push_back({vec4(particles.GetPosition(i), scale), vec4(1.0f)});
     }
 }
 
+// set per-instance attributes of the bound vertex array, sourced from the streaming buffer rewritten every frame
+static void setInstanceAttributes(const GLuint buffer, const usize offset)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)(offset + offsetof(ParticleInstance, position_and_scale)));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)(offset + offsetof(ParticleInstance, color)));
+    glVertexAttribDivisor(2, 1);
+}
+
 // render all particles
-void ParticleGenerator::Draw(const Shader& shader) const
+void ParticleGenerator::Submit(const Shader& shader, std::span<const ParticleInstance> alive_instances,
+    const nge::graphics::Frustum& frustum, nge::graphics::RenderQueue& queue, nge::graphics::StreamingBuffer& streaming_buffer)
 {
-    // make them spottable even behind other objects like the sun
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    shader.use();
-    for (const Particle &particle : particles)
+    alive_bounds.Clear();
+    for (const ParticleInstance &instance : alive_instances)
     {
-        if (particle.life > 0.0f) {
-            shader.setVec3("offset", particle.position);
-            // make the size proportionate to the time left
-            shader.setFloat("scale", particle.life / 8);
-            //shader.setVec4("color", particle.color);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glBindVertexArray(VAO);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            glBindVertexArray(0);
-        }
+        // the quad spans [0, scale] from the particle position on every axis (the texture coordinate ends up in z)
+        const float scale = instance.position_and_scale.w;
+        alive_bounds.Add(vec3(instance.position_and_scale) + vec3(scale / 2), scale * std::sqrt(3.0f) / 2);
     }
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
+
+    alive_bounds.Cull(frustum, visible_particles);
+    instances.clear();
+    for (const u32 index : visible_particles)
+        instances.push_back(alive_instances[index]);
+    if (instances.empty())
+        return;
+    const auto instance_data = streaming_buffer.Write(std::span<const ParticleInstance>(instances));
+
+    // make them spottable even behind other objects like the sun
+    nge::graphics::DrawPacket packet;
+    packet.sort_key = nge::graphics::RenderQueue::MakeSortKey(nge::graphics::RenderLayer::Overlay, shader.GetHandle(), texture, 0.0f);
+    packet.program = shader.GetHandle();
+    packet.state.depth_test = false;
+    packet.state.cull_face = false;
+    packet.state.blend_source_factor = GL_SRC_ALPHA;
+    packet.state.blend_destination_factor = GL_ONE;
+    packet.AddTexture(0, GL_TEXTURE_2D, texture);
+    packet.vertex_array = VAO;
+    packet.vertex_count = 6;
+    packet.instance_count = (u32)instances.size();
+    packet.set_instance_attributes = setInstanceAttributes;
+    packet.instance_buffer = instance_data.buffer;
+    packet.instance_offset = instance_data.offset;
+    queue.Submit(packet);
 }
 
 void ParticleGenerator::init()
@@ -77,49 +115,18 @@ void ParticleGenerator::init()
     };
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
+    StateCache::Current().BindVertexArray(VAO);
     // fill mesh buffer
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(particle_quad), particle_quad, GL_STATIC_DRAW);
     // set mesh attributes
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glBindVertexArray(0);
-
-    // create amount default particle instances
-    for (unsigned int i = 0; i < amount; ++i)
-        particles.push_back(Particle());
-}
-
-// stores the index of the last particle used (for quick access to next dead particle)
-unsigned int lastUsedParticle = 0;
-unsigned int ParticleGenerator::firstUnusedParticle()
-{
-    // first search from last used particle, this will usually return almost instantly
-    for (unsigned int i = lastUsedParticle; i < amount; ++i){
-        if (particles[i].life <= 0.0f){
-            lastUsedParticle = i;
-            return i;
-        }
-    }
-    // otherwise, do a linear search
-    for (unsigned int i = 0; i < lastUsedParticle; ++i){
-        if (particles[i].life <= 0.0f){
-            lastUsedParticle = i;
-            return i;
-        }
-    }
-    // all particles are taken, override the first one (note that if it repeatedly hits this case, more particles should be reserved)
-    lastUsedParticle = 0;
-    return 0;
-}
+    StateCache::Current().BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-void ParticleGenerator::respawnParticle(Particle &particle, glm::vec3 offset)
-{
-    // we don't need the color, but they work
-    //float rColor = ((rand() % 100) / 100.0f) - 0.3f;
-    particle.position = glm::vec3((rand() % 100)/10.0f + offset.x, (rand() % 100)/10.0f + offset.y, (rand() % 100)/10.0f + offset.z);
-    //particle.color = glm::vec4(rColor, rColor > 0.75f ? rColor / 2.f : 0.f, 0, 1.f);
-    particle.life = 1.0f;
-    particle.velocity = glm::vec3((rand() % 20) - 10, (rand() % 20) - 10, (rand() % 20) - 10) / 2.f;
+    const unsigned int amount = particles.GetCapacity();
+    alive_bounds.Reserve(amount);
+    visible_particles.reserve(amount);
+    instances.reserve(amount);
 }
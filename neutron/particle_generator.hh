@@ -3,54 +3,53 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include "import.hh"
+#include "nge_graphics.hh"
 
 // std headers
 #include <vector>
+#include <span>
 
 // nge headers
 #include "nge_math.hh"
+#include "nge_particles.hh"
+#include "nge_random.hh"
 
 class Shader;
 
-// Represents a single particle and its state
-struct Particle
-{
-	nge::math::Vector3 position, velocity;
-	nge::math::Vector4 color;
-	float life;
-
-	Particle():
-		position(), velocity(), color(1.0f), life(0.0f)
-	{}
-};
-
 // ParticleGenerator acts as a container for rendering a large number of
 // particles by repeatedly spawning and updating particles and killing
 // them after a given amount of time.
+// Generators share no state, so there can be as many emitters as needed.
 class ParticleGenerator
 {
 	// state
-	std::vector<Particle> particles;
-	unsigned int amount;
+	nge::ParticlePool particles;
+	nge::random::Stream random;
+	// positions and velocities of the particles spawned by an update, drawn all at once
+	std::vector<float> spawn_positions, spawn_velocities;
 	// render state
 	GLuint texture;
 	unsigned int VAO;
+	// bounds of the alive particles, rebuilt every frame
+	nge::graphics::BoundingSpheres alive_bounds;
+	std::vector<u32> visible_particles;
+	// alive particles in view, drawn with a single instanced draw call
+	std::vector<ParticleInstance> instances;
 
 	// initializes buffer and vertex attributes
 	void init();
 
-	// returns the first Particle index that's currently unused e.g. Life <= 0.0f or 0 if no particle is currently inactive
-	unsigned int firstUnusedParticle();
-
-	// respawns particle
-	void respawnParticle(Particle& particle, nge::math::Vector3 offset = nge::math::Vector3(0.0f, 0.0f, 0.0f));
-
 public:
-	ParticleGenerator(GLuint texture, unsigned int amount);
+	// generators with the same seed and stream spawn the same particles, so every emitter should have its own stream
+	ParticleGenerator(GLuint texture, unsigned int amount, u64 seed, u64 stream = 0);
 
 	// update all particles
 	void Update(float dt, unsigned int newParticles, nge::math::Vector3 offset = nge::math::Vector3(-5.0f, -5.0f, -5.0f));
 
-	// render all particles
-	void Draw(const Shader& shader) const;
+	// packs the alive particles, so that they can be drawn while the next update runs
+	void Pack(std::vector<ParticleInstance>& alive_instances) const;
+
+	// render all particles of a pack in view, on top of everything else
+	void Submit(const Shader& shader, std::span<const ParticleInstance> alive_instances, const nge::graphics::Frustum& frustum,
+		nge::graphics::RenderQueue& queue, nge::graphics::StreamingBuffer& streaming_buffer);
 };
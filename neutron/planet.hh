@@ -4,6 +4,10 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+// nge headers
+#include "nge_state_cache.hh"
+#include "nge_texture.hh"
+
 // std headers
 #include <iostream>
 #include <cmath>
@@ -18,7 +22,7 @@ GLuint generateMipmappedTexture(const std::string_view& imagePath) {
 
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    nge::graphics::StateCache::Current().BindTexture(0, GL_TEXTURE_2D, textureID);
 
     // Set texture parameters and generate mipmaps
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -30,7 +34,22 @@ GLuint generateMipmappedTexture(const std::string_view& imagePath) {
     glGenerateMipmap(GL_TEXTURE_2D);
 
     stbi_image_free(data);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    nge::graphics::StateCache::Current().BindTexture(0, GL_TEXTURE_2D, 0);
 
     return textureID;
 }
+
+// loads an image as RGB pixels, to be cooked into a texture array
+// returns an empty image when the file cannot be loaded
+nge::graphics::Image loadImage(const std::string_view& imagePath) {
+    int width, height, nrChannels;
+    unsigned char* data = stbi_load(imagePath.data(), &width, &height, &nrChannels, nge::graphics::Image::CHANNELS);
+    if (!data) {
+        std::cerr << "Failed to load texture: " << imagePath << '\n';
+        return {};
+    }
+
+    nge::graphics::Image image{(u32)width, (u32)height, std::vector<u8>(data, data + (usize)width * height * nge::graphics::Image::CHANNELS)};
+    stbi_image_free(data);
+    return image;
+}
@@ -9,6 +9,7 @@
 #include <string_view>
 
 // nge headers
+#include "nge_state_cache.hh"
 #include "types.hh"
 
 // utility function for loading a 2D texture from file
@@ -29,7 +30,7 @@ GLuint loadTexture(const std::string_view& path)
 		else if (nrComponents == 4)
 			format = GL_RGBA;
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		nge::graphics::StateCache::Current().BindTexture(0, GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -60,7 +61,7 @@ GLuint loadCubemap(const std::span<const std::string_view>& faces)
 {
 	GLuint textureID;
 	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+	nge::graphics::StateCache::Current().BindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
 
 	int width, height, nrChannels;
 	for (usize i = 0; i < faces.size(); i++)
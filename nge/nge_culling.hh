@@ -0,0 +1,212 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_math.hh"
+#include "types.hh"
+
+// std headers
+#include <array>
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <bit>
+
+// SSE2 is part of every x86-64 CPU, other architectures use the scalar path
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NGE_CULLING_SSE2 1
+#include <emmintrin.h>
+#else
+#define NGE_CULLING_SSE2 0
+#endif
+
+namespace nge::graphics
+{
+	// the 6 planes bounding what a camera sees, each stored as (normal, distance) with the normal pointing inside
+	// so that dot(plane.xyz, point) + plane.w is the signed distance of a point to the plane
+	struct Frustum
+	{
+		std::array<vec4, 6> planes;
+
+		// extracts the planes from a view-projection matrix with GL clip space conventions
+		static Frustum FromViewProjection(const mat4& view_projection)
+		{
+			// glm matrices are column-major, we need the rows
+			vec4 rows[4];
+			for (u32 i = 0; i < 4; i++)
+				rows[i] = vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+
+			Frustum frustum{{
+				rows[3] + rows[0], // left
+				rows[3] - rows[0], // right
+				rows[3] + rows[1], // bottom
+				rows[3] - rows[1], // top
+				rows[3] + rows[2], // near
+				rows[3] - rows[2], // far
+			}};
+			for (auto& plane : frustum.planes)
+				plane /= length(vec3(plane));
+			return frustum;
+		}
+
+		float GetSignedDistance(const u32 plane, const vec3& point) const
+		{
+			return dot(vec3(planes[plane]), point) + planes[plane].w;
+		}
+
+		// conservative: spheres near the corners may be reported visible while being just outside
+		bool IsSphereVisible(const vec3& center, const float radius) const
+		{
+			for (u32 plane = 0; plane < planes.size(); plane++)
+			{
+				if (GetSignedDistance(plane, center) < -radius)
+					return false;
+			}
+			return true;
+		}
+	};
+
+	// bounding spheres of candidate objects, laid out as structure of arrays so that several are tested at once
+	// consecutive spheres are grouped and each group is tested first, so adding nearby objects one after the other
+	// lets whole groups be rejected or accepted without testing their members
+	class BoundingSpheres
+	{
+	public:
+		static constexpr u32 GROUP_SIZE = 64;
+
+	private:
+		std::vector<float> x, y, z, radius;
+		// bounds of every group, enclosing its spheres entirely
+		std::vector<vec3> group_min, group_max;
+
+		// tests the spheres of [first, last) against the given planes only, and appends the visible ones
+		void CullRange(const Frustum& frustum, const std::span<const u32> planes, const usize first, const usize last,
+			std::vector<u32>& visible_indices) const
+		{
+			usize i = first;
+#if NGE_CULLING_SSE2
+			for (; i + 4 <= last; i += 4)
+			{
+				const __m128 center_x = _mm_loadu_ps(&x[i]);
+				const __m128 center_y = _mm_loadu_ps(&y[i]);
+				const __m128 center_z = _mm_loadu_ps(&z[i]);
+				const __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radius[i]));
+
+				__m128 outside = _mm_setzero_ps();
+				for (const u32 plane : planes)
+				{
+					const vec4& p = frustum.planes[plane];
+					// same order of operations as the scalar test, so that both agree on spheres touching a plane
+					__m128 distance = _mm_mul_ps(center_x, _mm_set1_ps(p.x));
+					distance = _mm_add_ps(distance, _mm_mul_ps(center_y, _mm_set1_ps(p.y)));
+					distance = _mm_add_ps(distance, _mm_mul_ps(center_z, _mm_set1_ps(p.z)));
+					distance = _mm_add_ps(distance, _mm_set1_ps(p.w));
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negative_radius));
+				}
+
+				for (u32 inside = ~static_cast<u32>(_mm_movemask_ps(outside)) & 0xF; inside != 0; inside &= inside - 1)
+					visible_indices.push_back(static_cast<u32>(i + std::countr_zero(inside)));
+			}
+#endif
+			for (; i < last; i++)
+			{
+				bool is_outside = false;
+				for (const u32 plane : planes)
+				{
+					const vec4& p = frustum.planes[plane];
+					is_outside |= p.x * x[i] + p.y * y[i] + p.z * z[i] + p.w < -radius[i];
+				}
+				if (!is_outside)
+					visible_indices.push_back(static_cast<u32>(i));
+			}
+		}
+
+	public:
+		void Reserve(const usize count)
+		{
+			x.reserve(count);
+			y.reserve(count);
+			z.reserve(count);
+			radius.reserve(count);
+		}
+
+		void Clear()
+		{
+			x.clear();
+			y.clear();
+			z.clear();
+			radius.clear();
+			group_min.clear();
+			group_max.clear();
+		}
+
+		// returns the index of the sphere, which Cull reports when it is visible
+		u32 Add(const vec3& center, const float sphere_radius)
+		{
+			const usize index = x.size();
+			x.push_back(center.x);
+			y.push_back(center.y);
+			z.push_back(center.z);
+			radius.push_back(sphere_radius);
+
+			if (index % GROUP_SIZE == 0)
+			{
+				group_min.push_back(center - sphere_radius);
+				group_max.push_back(center + sphere_radius);
+			}
+			else
+			{
+				group_min.back() = min(group_min.back(), center - sphere_radius);
+				group_max.back() = max(group_max.back(), center + sphere_radius);
+			}
+			return static_cast<u32>(index);
+		}
+
+		usize GetCount() const {return x.size();}
+
+		// replaces the given indices with the ones of the spheres intersecting the frustum, in increasing order
+		void Cull(const Frustum& frustum, std::vector<u32>& visible_indices) const
+		{
+			visible_indices.clear();
+
+			std::array<u32, 6> straddled_planes;
+			for (usize group = 0; group < group_min.size(); group++)
+			{
+				const vec3 group_center = (group_min[group] + group_max[group]) * 0.5f;
+				const float group_radius = length(group_max[group] - group_min[group]) * 0.5f;
+
+				// only the planes crossing the group need to be tested for its members
+				u32 straddled_plane_count = 0;
+				bool is_outside = false;
+				for (u32 plane = 0; plane < frustum.planes.size() && !is_outside; plane++)
+				{
+					const float distance = frustum.GetSignedDistance(plane, group_center);
+					if (distance < -group_radius)
+						is_outside = true;
+					else if (distance < group_radius)
+						straddled_planes[straddled_plane_count++] = plane;
+				}
+				if (is_outside)
+					continue;
+
+				const usize first = group * GROUP_SIZE;
+				const usize last = std::min(first + GROUP_SIZE, x.size());
+				if (straddled_plane_count == 0)
+				{
+					// entirely inside
+					for (usize i = first; i < last; i++)
+						visible_indices.push_back(static_cast<u32>(i));
+				}
+				else
+				{
+					CullRange(frustum, std::span<const u32>(straddled_planes.data(), straddled_plane_count), first, last,
+						visible_indices);
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,247 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_profiler.hh"
+#include "nge_timing.hh"
+#include "nge_window.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <array>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+namespace nge::graphics
+{
+	// measures how long the GPU spends on every frame, reading each result a few frames later so that it never waits
+	// it uses timestamps rather than GL_TIME_ELAPSED, whose queries cannot nest with the profiler's GPU scopes
+	class GpuFrameTimer
+	{
+	public:
+		// frames between issuing a frame's queries and reading them, by which time the GPU has long finished it
+		static constexpr u32 FRAME_LATENCY = 4;
+
+	private:
+		// start and end timestamps of each frame in flight
+		std::array<std::array<GLuint, 2>, FRAME_LATENCY> queries{};
+		std::array<bool, FRAME_LATENCY> is_pending{};
+		u32 frame;
+
+	public:
+		GpuFrameTimer():
+			frame(0)
+		{
+			for (auto& frame_queries : queries)
+				glGenQueries(2, frame_queries.data());
+		}
+
+		GpuFrameTimer(const GpuFrameTimer&) = delete;
+		GpuFrameTimer& operator=(const GpuFrameTimer&) = delete;
+
+		~GpuFrameTimer()
+		{
+			for (auto& frame_queries : queries)
+				glDeleteQueries(2, frame_queries.data());
+		}
+
+		// starts measuring a frame, and returns the GPU time of the one measured FRAME_LATENCY frames ago if it is done
+		std::optional<timing::Seconds> BeginFrame()
+		{
+			frame = (frame + 1) % FRAME_LATENCY;
+			std::optional<timing::Seconds> frame_time;
+			if (is_pending[frame])
+			{
+				GLint is_available = GL_FALSE;
+				glGetQueryObjectiv(queries[frame][1], GL_QUERY_RESULT_AVAILABLE, &is_available);
+				if (is_available)
+				{
+					GLuint64 start = 0, end = 0;
+					glGetQueryObjectui64v(queries[frame][0], GL_QUERY_RESULT, &start);
+					glGetQueryObjectui64v(queries[frame][1], GL_QUERY_RESULT, &end);
+					frame_time = static_cast<timing::Seconds>(static_cast<double>(end - start) * 1e-9);
+				}
+			}
+			glQueryCounter(queries[frame][0], GL_TIMESTAMP);
+			is_pending[frame] = false;
+			return frame_time;
+		}
+
+		void EndFrame()
+		{
+			glQueryCounter(queries[frame][1], GL_TIMESTAMP);
+			is_pending[frame] = true;
+		}
+	};
+
+	// picks the fraction of the window resolution to render at so that frames hold a GPU time budget
+	// the GPU time of a frame is mostly proportional to its pixel count, so the scale of each dimension follows the square
+	// root of the time ratio: it drops as soon as a frame goes over budget, and only rises back slowly and in small steps
+	// once frames are comfortably under it, so that it does not oscillate around the budget
+	class ResolutionScaler
+	{
+	public:
+		static constexpr float MIN_SCALE = 0.5f;
+		// scales are multiples of this, so that small variations of the frame time leave the resolution alone
+		static constexpr float SCALE_STEP = 1.0f / 32.0f;
+		// fraction of the budget aimed at, leaving room for frames heavier than the previous ones
+		static constexpr float HEADROOM = 0.85f;
+		// frames to wait after a change before rising again, the measured times being those of the previous resolution
+		// until then, and most increase per rise
+		static constexpr u32 RISE_DELAY = 30;
+		static constexpr float MAX_RISE = 0.05f;
+
+	private:
+		timing::Seconds budget;
+		float scale;
+		timing::Seconds average_time; // smoothed over the last frames
+		u32 frames_since_change;
+
+		static float Quantize(const float value)
+		{
+			return std::clamp(std::floor(value / SCALE_STEP) * SCALE_STEP, MIN_SCALE, 1.0f);
+		}
+
+	public:
+		explicit ResolutionScaler(const timing::Seconds budget):
+			budget(budget), scale(1.0f), average_time(0.0f), frames_since_change(0)
+		{}
+
+		// takes the GPU time of a frame rendered at the current scale, or at the previous one for the few frames after
+		// a change, and returns the scale of the next frames
+		float Update(const timing::Seconds frame_time)
+		{
+			frames_since_change++;
+			average_time = average_time > 0.0f ? average_time + (frame_time - average_time) * 0.25f : frame_time;
+			const timing::Seconds target_time = budget * HEADROOM;
+
+			float new_scale = scale;
+			if (frame_time > budget && frames_since_change > GpuFrameTimer::FRAME_LATENCY)
+				new_scale = Quantize(scale * std::sqrt(target_time / frame_time));
+			else if (average_time < target_time && frames_since_change > RISE_DELAY)
+			{
+				// at least a step, which near MIN_SCALE is more than MAX_RISE, unless it is predicted to exceed the target
+				const float rise = std::min(std::sqrt(target_time / average_time), 1.0f + MAX_RISE);
+				new_scale = std::max(Quantize(scale * rise), std::min(scale + SCALE_STEP, 1.0f));
+				const float area_ratio = (new_scale * new_scale) / (scale * scale);
+				if (average_time * area_ratio > target_time)
+					new_scale = scale;
+			}
+
+			if (new_scale != scale)
+			{
+				scale = new_scale;
+				frames_since_change = 0;
+			}
+			return scale;
+		}
+
+		float GetScale() const {return scale;}
+		timing::Seconds GetBudget() const {return budget;}
+	};
+
+	// offscreen color and depth the scene is drawn into at a fraction of the window resolution, then upscaled to the
+	// window with bilinear filtering
+	// the storage has the size of the window and the scene only uses its lower left corner, so that changing the
+	// scale never reallocates anything
+	class ScaledRenderTarget
+	{
+		GLuint framebuffer;
+		GLuint color_renderbuffer;
+		GLuint depth_renderbuffer;
+		Extent2D size;
+		float scale;
+		Extent2D render_size;
+		// the window's framebuffer, which is not 0 for headless windows
+		GLint presentation_framebuffer;
+
+		void Allocate()
+		{
+			glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, (GLsizei)size.width, (GLsizei)size.height);
+			glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, (GLsizei)size.width, (GLsizei)size.height);
+			glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		}
+
+	public:
+		explicit ScaledRenderTarget(const Extent2D& size):
+			framebuffer(0), color_renderbuffer(0), depth_renderbuffer(0), size(size), scale(1.0f), render_size(size),
+			presentation_framebuffer(0)
+		{
+			glGenRenderbuffers(1, &color_renderbuffer);
+			glGenRenderbuffers(1, &depth_renderbuffer);
+			Allocate();
+
+			GLint bound_framebuffer = 0;
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound_framebuffer);
+			glGenFramebuffers(1, &framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_renderbuffer);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_renderbuffer);
+			const bool is_complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+			glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)bound_framebuffer);
+			if (!is_complete)
+				throw std::runtime_error("Failed to create the scaled render target.");
+		}
+
+		ScaledRenderTarget(const ScaledRenderTarget&) = delete;
+		ScaledRenderTarget& operator=(const ScaledRenderTarget&) = delete;
+
+		~ScaledRenderTarget()
+		{
+			glDeleteFramebuffers(1, &framebuffer);
+			glDeleteRenderbuffers(1, &depth_renderbuffer);
+			glDeleteRenderbuffers(1, &color_renderbuffer);
+		}
+
+		// follows the window size, keeping the scale
+		void Resize(const Extent2D& new_size)
+		{
+			size = new_size;
+			Allocate();
+			SetScale(scale);
+		}
+
+		void SetScale(const float new_scale)
+		{
+			scale = new_scale;
+			render_size = Extent2D(std::max(1u, static_cast<u32>(std::lround(static_cast<float>(size.width) * scale))),
+				std::max(1u, static_cast<u32>(std::lround(static_cast<float>(size.height) * scale))));
+		}
+
+		// binds the target for the scene, until End
+		void Begin()
+		{
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &presentation_framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glViewport(0, 0, (GLsizei)render_size.width, (GLsizei)render_size.height);
+		}
+
+		// upscales the scene to the window's framebuffer, which is bound again
+		void End()
+		{
+			NGE_PROFILE_GPU_SCOPE("Upscale");
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)presentation_framebuffer);
+			glBlitFramebuffer(0, 0, (GLint)render_size.width, (GLint)render_size.height, 0, 0, (GLint)size.width,
+				(GLint)size.height, GL_COLOR_BUFFER_BIT, render_size.width == size.width ? GL_NEAREST : GL_LINEAR);
+			glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)presentation_framebuffer);
+			glViewport(0, 0, (GLsizei)size.width, (GLsizei)size.height);
+		}
+
+		const Extent2D& GetSize() const {return size;}
+		// part of the target the scene is drawn into
+		const Extent2D& GetRenderSize() const {return render_size;}
+		float GetScale() const {return scale;}
+	};
+}
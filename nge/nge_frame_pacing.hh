@@ -0,0 +1,259 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_profiler.hh"
+#include "nge_timing.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <array>
+#include <deque>
+#include <vector>
+#include <span>
+#include <optional>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+
+namespace nge
+{
+	// percentiles of the time between polling the input of a frame and the GPU completing its buffer swap
+	struct LatencyReport
+	{
+		usize sample_count;
+		timing::Seconds median;
+		timing::Seconds percentile_90;
+		timing::Seconds percentile_99;
+		timing::Seconds max;
+	};
+
+	// paces frames for latency rather than throughput, and measures the latency between polling input and swapping
+	// drivers let the CPU queue a few frames ahead of the GPU, each of them adding a frame of latency to the input it
+	// used: the pacer waits on a fence of the previous frames instead, and can then also delay the start of the frame so
+	// that it is ready just before vsync, predicting the refresh interval and the work of the frame from the last ones
+	// the swap is timed with a timestamp query issued after it, converted to the CPU clock, which the GPU passes once it
+	// has executed the swap: scanout and any compositor still come after it, so the latencies are lower bounds of the
+	// time until the frame is on screen
+	class FramePacer
+	{
+	public:
+		struct Settings
+		{
+			// frames the CPU may get ahead of the GPU, or 0 to leave it to the driver
+			u32 max_frames_in_flight = 0;
+			// delay the start of frames so that they are ready just before vsync, for a limited number of frames in flight
+			bool is_just_in_time = false;
+		};
+
+		// frames between issuing a frame's timestamps and reading them, when the driver queues frames
+		static constexpr u32 QUERY_LATENCY = 8;
+		// recent frames whose work and present interval predict the next one
+		static constexpr u32 HISTORY_SIZE = 64;
+		// time left between a just in time frame being ready and vsync, for frames heavier than the predicted one
+		static constexpr timing::Seconds JUST_IN_TIME_MARGIN = 0.002f;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct FrameTimings
+		{
+			std::array<GLuint, 2> queries; // timestamps of the frame being ready to present, and of its swap completing
+			Clock::time_point start_time;
+			Clock::time_point input_time;
+			bool is_pending;
+		};
+
+		Settings settings;
+		std::array<FrameTimings, QUERY_LATENCY> frames{};
+		u32 frame;
+		std::deque<GLsync> fences;
+		// CPU clock minus GPU clock, to convert timestamps
+		std::chrono::nanoseconds clock_offset;
+		Clock::time_point frame_start_time;
+		Clock::time_point input_time; // of the latest poll
+		std::optional<Clock::time_point> last_present_time;
+
+		// from the start of a frame to it being ready to present, and between consecutive swaps completing
+		std::array<timing::Seconds, HISTORY_SIZE> work_times{};
+		std::array<timing::Seconds, HISTORY_SIZE> present_intervals{};
+		u32 work_time_count;
+		u32 present_interval_count;
+		timing::Seconds delay;
+		std::vector<timing::Seconds> latencies;
+
+		static timing::Seconds ToSeconds(const Clock::duration duration)
+		{
+			return std::chrono::duration<timing::Seconds>(duration).count();
+		}
+
+		// nearest rank percentile, fraction being between 0 and 1
+		static timing::Seconds GetPercentile(const std::span<const timing::Seconds> samples, const float fraction)
+		{
+			std::vector<timing::Seconds> sorted(samples.begin(), samples.end());
+			const usize rank = std::min(sorted.size() - 1, static_cast<usize>(fraction * static_cast<float>(sorted.size())));
+			std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(rank), sorted.end());
+			return sorted[rank];
+		}
+
+		// the GPU clock only drifts slowly from the CPU one, but may be reset, so this runs every frame
+		void CalibrateClocks()
+		{
+			GLint64 gpu_time = 0;
+			glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+			clock_offset = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()) -
+				std::chrono::nanoseconds(gpu_time);
+		}
+
+		Clock::time_point ToCpuTime(const GLuint64 gpu_time) const
+		{
+			return Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+				std::chrono::nanoseconds(static_cast<s64>(gpu_time)) + clock_offset));
+		}
+
+		// reads the timestamps of the swapped frames in order, stopping at the first one the GPU has not passed yet
+		void ReadTimings()
+		{
+			// the next frame's timings are the oldest
+			for (u32 i = 0; i < QUERY_LATENCY; i++)
+			{
+				FrameTimings& timings = frames[(frame + i) % QUERY_LATENCY];
+				if (!timings.is_pending)
+					continue;
+
+				GLint is_available = GL_FALSE;
+				glGetQueryObjectiv(timings.queries[1], GL_QUERY_RESULT_AVAILABLE, &is_available);
+				if (!is_available)
+					break;
+
+				GLuint64 ready_time = 0, swap_time = 0;
+				glGetQueryObjectui64v(timings.queries[0], GL_QUERY_RESULT, &ready_time);
+				glGetQueryObjectui64v(timings.queries[1], GL_QUERY_RESULT, &swap_time);
+				timings.is_pending = false;
+
+				const Clock::time_point swapped = ToCpuTime(swap_time);
+				latencies.push_back(ToSeconds(swapped - timings.input_time));
+				work_times[work_time_count++ % HISTORY_SIZE] = ToSeconds(ToCpuTime(ready_time) - timings.start_time);
+				if (last_present_time)
+					present_intervals[present_interval_count++ % HISTORY_SIZE] = ToSeconds(swapped - *last_present_time);
+				last_present_time = swapped;
+			}
+		}
+
+		// the median present interval is the refresh interval, or a multiple of it when frames miss vsync, and the work
+		// of the next frame is predicted pessimistically, so that only a few frames are late
+		void UpdateDelay()
+		{
+			if (present_interval_count < HISTORY_SIZE / 4)
+				return;
+
+			const timing::Seconds refresh_interval = GetPercentile(
+				std::span(present_intervals).first(std::min(present_interval_count, HISTORY_SIZE)), 0.5f);
+			const timing::Seconds work_time = GetPercentile(
+				std::span(work_times).first(std::min(work_time_count, HISTORY_SIZE)), 0.95f);
+			delay = std::clamp(refresh_interval - work_time - JUST_IN_TIME_MARGIN, 0.0f, refresh_interval);
+		}
+
+	public:
+		explicit FramePacer(const Settings& settings):
+			settings(settings), frame(0), fences(), clock_offset(0), frame_start_time(Clock::now()),
+			input_time(frame_start_time), last_present_time(), work_time_count(0), present_interval_count(0), delay(0.0f),
+			latencies()
+		{
+			for (FrameTimings& timings : frames)
+				glGenQueries(2, timings.queries.data());
+			CalibrateClocks();
+		}
+
+		FramePacer(const FramePacer&) = delete;
+		FramePacer& operator=(const FramePacer&) = delete;
+
+		~FramePacer()
+		{
+			for (const GLsync fence : fences)
+				glDeleteSync(fence);
+			for (FrameTimings& timings : frames)
+				glDeleteQueries(2, timings.queries.data());
+		}
+
+		// waits until the frame should start, before polling its input when latency matters
+		void BeginFrame()
+		{
+			NGE_PROFILE_SCOPE("FramePacer::BeginFrame");
+			while (settings.max_frames_in_flight > 0 && fences.size() >= settings.max_frames_in_flight)
+			{
+				constexpr GLuint64 TIMEOUT = 1'000'000'000; // in nanoseconds
+				GLenum status;
+				while ((status = glClientWaitSync(fences.front(), GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT)) == GL_TIMEOUT_EXPIRED)
+					;
+				if (status == GL_WAIT_FAILED)
+					throw std::runtime_error("Failed to wait for the GPU to present a frame.");
+				glDeleteSync(fences.front());
+				fences.pop_front();
+			}
+			ReadTimings();
+
+			// the frame just waited for is presented on a vsync, so the next one is a refresh interval later
+			if (settings.is_just_in_time && settings.max_frames_in_flight > 0)
+			{
+				UpdateDelay();
+				if (delay > 0.0f)
+					std::this_thread::sleep_for(std::chrono::duration<timing::Seconds>(delay));
+			}
+
+			CalibrateClocks();
+			frame_start_time = Clock::now();
+		}
+
+		// the latest input, which the next frame to be presented uses
+		void OnInputPolled()
+		{
+			input_time = Clock::now();
+		}
+
+		// right before presenting the frame
+		void OnFrameReady()
+		{
+			FrameTimings& timings = frames[frame];
+			// the timings of frames which the GPU is still that far behind are lost, and with them the present interval
+			if (timings.is_pending)
+				last_present_time.reset();
+			glQueryCounter(timings.queries[0], GL_TIMESTAMP);
+			timings.start_time = frame_start_time;
+			timings.input_time = input_time;
+			timings.is_pending = false;
+		}
+
+		// right after swapping buffers, which the GPU then times when it completes the swap rather than when the frame
+		// reaches the screen
+		void OnFramePresented()
+		{
+			glQueryCounter(frames[frame].queries[1], GL_TIMESTAMP);
+			frames[frame].is_pending = true;
+			frame = (frame + 1) % QUERY_LATENCY;
+			if (settings.max_frames_in_flight > 0)
+				fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+		}
+
+		// latency of every frame swapped so far, once the GPU has finished them
+		LatencyReport GetLatencyReport()
+		{
+			ReadTimings();
+			if (latencies.empty())
+				return LatencyReport{0, 0.0f, 0.0f, 0.0f, 0.0f};
+			return LatencyReport{latencies.size(), GetPercentile(latencies, 0.5f), GetPercentile(latencies, 0.9f),
+				GetPercentile(latencies, 0.99f), *std::max_element(latencies.begin(), latencies.end())};
+		}
+
+		// current delay of the frame starts, 0 unless frames are just in time
+		timing::Seconds GetDelay() const {return delay;}
+	};
+}
@@ -0,0 +1,216 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_math.hh"
+#include "nge_profiler.hh"
+#include "nge_render_queue.hh"
+#include "nge_shader.hh"
+#include "nge_state_cache.hh"
+#include "nge_timing.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace nge::graphics
+{
+	// state of a particle simulated on the GPU, as read and written by the update program
+	struct GpuParticle
+	{
+		vec4 position_and_life; // the particle is dead once its life is down to zero
+		vec4 velocity; // w is unused
+	};
+
+	// particles simulated entirely on the GPU with transform feedback, the CPU doing no per-particle work at all
+	// the particles live in two buffers used in turn: every step, the update program reads each particle from one and
+	// writes it into the other, which is then drawn straight from the GPU as instances of a quad
+	// particles are spawned without any atomic counter: slots are handed out in order from a ring, a step respawning the
+	// next spawn_count ones, which are the oldest, so a slot is only reused once the whole ring has been spawned since
+	// the respawned particles draw their random numbers from hashes of their slot and of the step, so a simulation is the
+	// same from one run and one driver to the next for the same seed
+	// the matching shaders are particle_update.vs for the update program (with UPDATE_VARYINGS), and particle_gpu.vs
+	// with particle.fs to draw them
+	class GpuParticleSystem
+	{
+	public:
+		// outputs of the update program, captured in the layout of GpuParticle
+		static constexpr std::array<const char*, 2> UPDATE_VARYINGS = {"out_position_and_life", "out_velocity"};
+
+		// attribute locations, of the update program and of the instances when drawing
+		static constexpr GLuint POSITION_AND_LIFE_ATTRIBUTE = 1;
+		static constexpr GLuint VELOCITY_ATTRIBUTE = 2;
+
+	private:
+		u32 capacity;
+		const Shader& update_shader;
+		Uniform delta_time_uniform;
+		Uniform first_spawned_uniform;
+		Uniform spawn_count_uniform;
+		Uniform capacity_uniform;
+		Uniform seed_uniform;
+		Uniform step_uniform;
+		Uniform spawn_origin_uniform;
+
+		// particles, read from one buffer and written into the other every step
+		std::array<GLuint, 2> buffers{};
+		// reading the particles of each buffer, to update them
+		std::array<GLuint, 2> update_arrays{};
+		// capturing the particles into each buffer
+		std::array<GLuint, 2> feedbacks{};
+		// drawing a quad for each particle of each buffer
+		std::array<GLuint, 2> draw_arrays{};
+		GLuint quad_buffer;
+		u32 current; // buffer holding the latest particles
+
+		u32 next_spawned; // first slot of the ring respawned by the next step
+		u32 seed;
+		u32 step_count;
+
+	public:
+		GpuParticleSystem(const u32 capacity, const Shader& update_shader, const u32 seed = 0):
+			capacity(std::max(capacity, 1u)), update_shader(update_shader),
+			delta_time_uniform(update_shader.GetUniform("delta_time")),
+			first_spawned_uniform(update_shader.GetUniform("first_spawned")),
+			spawn_count_uniform(update_shader.GetUniform("spawn_count")),
+			capacity_uniform(update_shader.GetUniform("capacity")),
+			seed_uniform(update_shader.GetUniform("seed")),
+			step_uniform(update_shader.GetUniform("step")),
+			spawn_origin_uniform(update_shader.GetUniform("spawn_origin")),
+			quad_buffer(0), current(0), next_spawned(0), seed(seed), step_count(0)
+		{
+			// corners of the quad from the particle position, and their texture coordinates
+			// the shader reads the first three as the offset, so the texture coordinate ends up in z like for CPU particles
+			constexpr float quad[] =
+			{
+				0.0f, 1.0f, 0.0f, 1.0f,
+				1.0f, 0.0f, 1.0f, 0.0f,
+				0.0f, 0.0f, 0.0f, 0.0f,
+
+				0.0f, 1.0f, 0.0f, 1.0f,
+				1.0f, 1.0f, 1.0f, 1.0f,
+				1.0f, 0.0f, 1.0f, 0.0f
+			};
+			glGenBuffers(1, &quad_buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+			// every particle starts dead, with a life of zero
+			const std::vector<GpuParticle> particles(this->capacity, GpuParticle{vec4(0.0f), vec4(0.0f)});
+			glGenBuffers(2, buffers.data());
+			glGenVertexArrays(2, update_arrays.data());
+			glGenVertexArrays(2, draw_arrays.data());
+			glGenTransformFeedbacks(2, feedbacks.data());
+			for (u32 i = 0; i < 2; i++)
+			{
+				glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+				glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(particles.size() * sizeof(GpuParticle)), particles.data(),
+					GL_DYNAMIC_COPY);
+
+				StateCache::Current().BindVertexArray(update_arrays[i]);
+				glEnableVertexAttribArray(POSITION_AND_LIFE_ATTRIBUTE);
+				glVertexAttribPointer(POSITION_AND_LIFE_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(GpuParticle),
+					(void*)offsetof(GpuParticle, position_and_life));
+				glEnableVertexAttribArray(VELOCITY_ATTRIBUTE);
+				glVertexAttribPointer(VELOCITY_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(GpuParticle),
+					(void*)offsetof(GpuParticle, velocity));
+
+				// the velocity is not needed to draw
+				StateCache::Current().BindVertexArray(draw_arrays[i]);
+				glEnableVertexAttribArray(POSITION_AND_LIFE_ATTRIBUTE);
+				glVertexAttribPointer(POSITION_AND_LIFE_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(GpuParticle),
+					(void*)offsetof(GpuParticle, position_and_life));
+				glVertexAttribDivisor(POSITION_AND_LIFE_ATTRIBUTE, 1);
+				glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+				glEnableVertexAttribArray(0);
+				glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+
+				glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedbacks[i]);
+				glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[i]);
+			}
+			glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+			StateCache::Current().BindVertexArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		GpuParticleSystem(const GpuParticleSystem&) = delete;
+		GpuParticleSystem& operator=(const GpuParticleSystem&) = delete;
+
+		~GpuParticleSystem()
+		{
+			glDeleteTransformFeedbacks(2, feedbacks.data());
+			glDeleteVertexArrays(2, update_arrays.data());
+			glDeleteVertexArrays(2, draw_arrays.data());
+			for (u32 i = 0; i < 2; i++)
+			{
+				StateCache::Current().OnVertexArrayDeleted(update_arrays[i]);
+				StateCache::Current().OnVertexArrayDeleted(draw_arrays[i]);
+			}
+			glDeleteBuffers(2, buffers.data());
+			glDeleteBuffers(1, &quad_buffer);
+		}
+
+		// respawns spawn_count particles around the origin then moves every particle by the time, as a single pass on the
+		// GPU which is issued right away, particles spawned beyond the capacity replace the ones spawned just before
+		void Update(const timing::Seconds time, const u32 spawn_count, const vec3& spawn_origin)
+		{
+			// a stopped simulation keeps drawing the same particles
+			if (time <= 0.0f)
+				return;
+
+			NGE_PROFILE_SCOPE("GpuParticleSystem::Update");
+			NGE_PROFILE_GPU_SCOPE("Particle update");
+			const u32 next = 1 - current;
+			const u32 spawned = std::min(spawn_count, capacity);
+
+			StateCache& state = StateCache::Current();
+			update_shader.Use();
+			update_shader.SetUniform(delta_time_uniform, time);
+			update_shader.SetUniform(first_spawned_uniform, next_spawned);
+			update_shader.SetUniform(spawn_count_uniform, spawned);
+			update_shader.SetUniform(capacity_uniform, capacity);
+			update_shader.SetUniform(seed_uniform, seed);
+			update_shader.SetUniform(step_uniform, step_count);
+			update_shader.SetUniform(spawn_origin_uniform, spawn_origin);
+			state.BindVertexArray(update_arrays[current]);
+
+			// only the captured outputs matter, nothing is rasterized
+			glEnable(GL_RASTERIZER_DISCARD);
+			glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedbacks[next]);
+			glBeginTransformFeedback(GL_POINTS);
+			glDrawArrays(GL_POINTS, 0, (GLsizei)capacity);
+			glEndTransformFeedback();
+			glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+			glDisable(GL_RASTERIZER_DISCARD);
+
+			current = next;
+			next_spawned = (next_spawned + spawned) % capacity;
+			step_count++;
+		}
+
+		// packet drawing a quad per particle, dead ones being shrunk to nothing by the shader, the caller sets its key,
+		// program, state and texture
+		DrawPacket MakeDrawPacket() const
+		{
+			DrawPacket packet;
+			packet.vertex_array = draw_arrays[current];
+			packet.vertex_count = 6;
+			packet.instance_count = capacity;
+			return packet;
+		}
+
+		u32 GetCapacity() const {return capacity;}
+		// buffer holding the particles of the last step, as GpuParticle
+		GLuint GetBuffer() const {return buffers[current];}
+	};
+}
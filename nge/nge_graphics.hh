@@ -7,12 +7,23 @@
 
 // engine headers
 #include "nge_math.hh"
+#include "nge_render_queue.hh"
+#include "nge_state_cache.hh"
+#include "nge_streaming.hh"
+#include "types.hh"
 
 // GL headers
 #include <glad/glad.h>
 
 // std headers
 #include <span>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 
 namespace nge::graphics
 {
@@ -24,31 +35,129 @@ namespace nge::graphics
 		vec2 texcoord;
 	};
 
+	// VertexFormat quantized into 20 bytes instead of 44, for dense meshes whose vertex fetching dominates
+	// every attribute is normalized by the vertex fetcher, so shaders read it exactly like the VertexFormat one
+	// positions must be within the unit cube, which the instance matrices scale to the size of the object,
+	// normals and tangents keep about 3 significant digits, and texture coordinates are exact to a texel of a 2048 wide
+	// texture between 0 and 1, and of a 1024 wide one up to 2
+	struct PackedVertexFormat
+	{
+		std::array<s16, 4> position; // snorm16, w is unused
+		u32 normal; // snorm 10_10_10_2, w is unused
+		u32 tangent; // snorm 10_10_10_2, w is unused
+		u32 texcoord; // two half floats, u in the low bits
+	};
+
+	// quantizes vertices, whose positions must be within the unit cube rather than be silently clamped into it
+	inline void PackVertices(const std::span<const VertexFormat> vertices, std::vector<PackedVertexFormat>& packed_vertices)
+	{
+		for (const VertexFormat& vertex : vertices)
+			if (std::max({std::abs(vertex.position.x), std::abs(vertex.position.y), std::abs(vertex.position.z)}) > 1.0f)
+				throw std::runtime_error("Packed vertex positions must be within the unit cube.");
+
+		// signed normalized integers, with the GL 4.2 conversion rules which drivers also apply to older contexts
+		auto pack_snorm16 = [](const float value)
+		{
+			return static_cast<s16>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+		};
+		auto pack_snorm10 = [](const vec3& value)
+		{
+			u32 packed = 0;
+			for (u32 axis = 0; axis < 3; axis++)
+			{
+				const s32 component = static_cast<s32>(std::round(std::clamp(value[axis], -1.0f, 1.0f) * 511.0f));
+				packed |= (static_cast<u32>(component) & 0x3FF) << (axis * 10);
+			}
+			return packed;
+		};
+
+		packed_vertices.clear();
+		packed_vertices.reserve(vertices.size());
+		for (const VertexFormat& vertex : vertices)
+		{
+			const vec3& position = vertex.position;
+			packed_vertices.push_back({{pack_snorm16(position.x), pack_snorm16(position.y), pack_snorm16(position.z), 0},
+				pack_snorm10(vertex.normal), pack_snorm10(vertex.tangent), packHalf2x16(vertex.texcoord)});
+		}
+	}
+
+	// per-instance data of instanced draws, one per drawn copy of a model
+	struct InstanceFormat
+	{
+		mat4 model_to_world_matrix;
+		u32 material_index;
+		float ambient; // intensity of the light the instance receives regardless of any light source
+	};
+
+	// vertex attribute locations of InstanceFormat, right after the ones of VertexFormat
+	static constexpr GLuint INSTANCE_MATRIX_ATTRIBUTE = 4; // takes 4 locations, one per column
+	static constexpr GLuint INSTANCE_MATERIAL_ATTRIBUTE = 8;
+	static constexpr GLuint INSTANCE_AMBIENT_ATTRIBUTE = 9;
+
+	// sources the InstanceFormat attributes of the bound vertex array from the instances at the offset of the buffer
+	inline void SetInstanceAttributes(const GLuint buffer, const usize offset)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		for (GLuint column = 0; column < 4; column++)
+		{
+			glEnableVertexAttribArray(INSTANCE_MATRIX_ATTRIBUTE + column);
+			glVertexAttribPointer(INSTANCE_MATRIX_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceFormat),
+				(void *)(offset + offsetof(InstanceFormat, model_to_world_matrix) + sizeof(vec4) * column));
+			glVertexAttribDivisor(INSTANCE_MATRIX_ATTRIBUTE + column, 1);
+		}
+		glEnableVertexAttribArray(INSTANCE_MATERIAL_ATTRIBUTE);
+		glVertexAttribIPointer(INSTANCE_MATERIAL_ATTRIBUTE, 1, GL_UNSIGNED_INT, sizeof(InstanceFormat), (void *)(offset + offsetof(InstanceFormat, material_index)));
+		glVertexAttribDivisor(INSTANCE_MATERIAL_ATTRIBUTE, 1);
+		glEnableVertexAttribArray(INSTANCE_AMBIENT_ATTRIBUTE);
+		glVertexAttribPointer(INSTANCE_AMBIENT_ATTRIBUTE, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceFormat), (void *)(offset + offsetof(InstanceFormat, ambient)));
+		glVertexAttribDivisor(INSTANCE_AMBIENT_ATTRIBUTE, 1);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
 	class Model
 	{
 		GLuint VAO;
 		GLuint VBO;
 		GLuint EBO;
 		u32 vertex_index_count;
+		GLenum index_type;
 
-	public:
-		Model(const std::span<const VertexFormat>& vertices, const std::span<const u16>& vertex_indices):
-			VAO(0), VBO(0), EBO(0), vertex_index_count(vertex_indices.size())
+		// creates the buffers and binds the vertex array, for the constructors to set the vertex attributes
+		void Create(const void* vertices, const usize vertices_size, const usize vertex_count,
+			const std::span<const u32>& vertex_indices)
 		{
 			glGenVertexArrays(1, &VAO);
 			glGenBuffers(1, &VBO);
 			glGenBuffers(1, &EBO);
 
-			glBindVertexArray(VAO);
+			StateCache::Current().BindVertexArray(VAO);
 
 			// fill vertex buffer
 			glBindBuffer(GL_ARRAY_BUFFER, VBO);
-			glBufferData(GL_ARRAY_BUFFER, (GLuint)vertices.size_bytes(), vertices.data(), GL_STATIC_DRAW);
+			glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertices_size, vertices, GL_STATIC_DRAW);
 
-			// fill index buffer
+			// fill index buffer, with 16-bit indices whenever they can address every vertex, which halves index fetching
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLuint)vertex_indices.size_bytes(), vertex_indices.data(),
-						 GL_STATIC_DRAW);
+			if (vertex_count <= static_cast<usize>(std::numeric_limits<u16>::max()) + 1)
+			{
+				const std::vector<u16> short_indices(vertex_indices.begin(), vertex_indices.end());
+				glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(short_indices.size() * sizeof(u16)), short_indices.data(),
+							 GL_STATIC_DRAW);
+				index_type = GL_UNSIGNED_SHORT;
+			}
+			else
+			{
+				glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)vertex_indices.size_bytes(), vertex_indices.data(),
+							 GL_STATIC_DRAW);
+				index_type = GL_UNSIGNED_INT;
+			}
+		}
+
+	public:
+		Model(const std::span<const VertexFormat>& vertices, const std::span<const u32>& vertex_indices):
+			VAO(0), VBO(0), EBO(0), vertex_index_count(vertex_indices.size()), index_type(GL_UNSIGNED_SHORT)
+		{
+			Create(vertices.data(), vertices.size_bytes(), vertices.size(), vertex_indices);
 			glEnableVertexAttribArray(0);
 			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexFormat), (void *)offsetof(VertexFormat, position));
 			glEnableVertexAttribArray(1);
@@ -58,7 +167,23 @@ namespace nge::graphics
 			glEnableVertexAttribArray(3);
 			glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(VertexFormat), (void *)offsetof(VertexFormat, texcoord));
 
-			glBindVertexArray(0);
+			StateCache::Current().BindVertexArray(0);
+		}
+
+		Model(const std::span<const PackedVertexFormat>& vertices, const std::span<const u32>& vertex_indices):
+			VAO(0), VBO(0), EBO(0), vertex_index_count(vertex_indices.size()), index_type(GL_UNSIGNED_SHORT)
+		{
+			Create(vertices.data(), vertices.size_bytes(), vertices.size(), vertex_indices);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(PackedVertexFormat), (void *)offsetof(PackedVertexFormat, position));
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertexFormat), (void *)offsetof(PackedVertexFormat, normal));
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertexFormat), (void *)offsetof(PackedVertexFormat, tangent));
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertexFormat), (void *)offsetof(PackedVertexFormat, texcoord));
+
+			StateCache::Current().BindVertexArray(0);
 		}
 
 		~Model()
@@ -66,21 +191,38 @@ namespace nge::graphics
 			glDeleteBuffers(1, &EBO);
 			glDeleteBuffers(1, &VBO);
 			glDeleteVertexArrays(1, &VAO);
+			StateCache::Current().OnVertexArrayDeleted(VAO);
 		}
 
 		void Set() const
 		{
-			glBindVertexArray(VAO);
+			StateCache::Current().BindVertexArray(VAO);
 		}
 
 		void Draw() const
 		{
-			glDrawElements(GL_TRIANGLES, (GLint)vertex_index_count, GL_UNSIGNED_SHORT, nullptr);
+			glDrawElements(GL_TRIANGLES, (GLint)vertex_index_count, index_type, nullptr);
 		}
 
 		void Unset() const
 		{
-			glBindVertexArray(0);
+			StateCache::Current().BindVertexArray(0);
+		}
+
+		// packet drawing the given InstanceFormat instances, the caller sets its key, program, state and textures
+		DrawPacket MakeDrawPacket(const StreamAllocation& instances) const
+		{
+			DrawPacket packet;
+			packet.vertex_array = VAO;
+			packet.primitive = GL_TRIANGLES;
+			packet.vertex_count = vertex_index_count;
+			packet.is_indexed = true;
+			packet.index_type = index_type;
+			packet.instance_count = static_cast<u32>(instances.size / sizeof(InstanceFormat));
+			packet.set_instance_attributes = SetInstanceAttributes;
+			packet.instance_buffer = instances.buffer;
+			packet.instance_offset = instances.offset;
+			return packet;
 		}
 	};
 }
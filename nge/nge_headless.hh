@@ -0,0 +1,228 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_window.hh"
+#include "nge_profiler.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// std headers
+#include <vector>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+
+namespace nge
+{
+	// renders without any window nor display server, into a framebuffer object of an EGL context
+	// the context is surfaceless when the driver allows it, so this works on build machines without a GPU with Mesa's
+	// llvmpipe, and presenting never waits for vsync so frames are as fast as the GPU allows
+	// frames can be dumped as PPM images, which reads them back and so stalls the pipeline
+	class HeadlessWindow
+	{
+		EGLDisplay display;
+		EGLSurface surface;
+		EGLContext context;
+		GLuint framebuffer;
+		GLuint color_renderbuffer;
+		GLuint depth_renderbuffer;
+
+		Extent2D dimensions;
+		u32 frame_count;
+		u32 presented_frame_count;
+		std::optional<std::filesystem::path> dump_directory;
+		u32 dump_interval;
+		std::vector<u8> dump_pixels;
+
+		static bool HasExtension(const char* extensions, const std::string_view extension)
+		{
+			if (!extensions)
+				return false;
+			const std::string_view list = extensions;
+			for (usize start = 0; start < list.size();)
+			{
+				const usize end = std::min(list.find(' ', start), list.size());
+				if (list.substr(start, end - start) == extension)
+					return true;
+				start = end + 1;
+			}
+			return false;
+		}
+
+		static EGLDisplay GetDisplay()
+		{
+			// the surfaceless platform needs neither X11 nor Wayland nor a DRM device
+			const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+			if (HasExtension(client_extensions, "EGL_MESA_platform_surfaceless") &&
+				HasExtension(client_extensions, "EGL_EXT_platform_base"))
+			{
+				const auto get_platform_display =
+					(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+				if (get_platform_display)
+				{
+					const EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+					if (display != EGL_NO_DISPLAY)
+						return display;
+				}
+			}
+			return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+
+		void DumpFrame()
+		{
+			glReadPixels(0, 0, (GLsizei)dimensions.width, (GLsizei)dimensions.height, GL_RGB, GL_UNSIGNED_BYTE,
+				dump_pixels.data());
+
+			std::string number = std::to_string(presented_frame_count);
+			number.insert(0, number.size() < 5 ? 5 - number.size() : 0, '0');
+			const auto path = *dump_directory / ("frame_" + number + ".ppm");
+			std::ofstream file(path, std::ios::binary);
+			if (!file)
+				throw std::runtime_error("Failed to open the frame dump " + path.string() + '.');
+			file << "P6\n" << dimensions.width << ' ' << dimensions.height << "\n255\n";
+			// GL rows go from the bottom up, image rows from the top down
+			const usize row_size = dimensions.width * 3;
+			for (u32 row = dimensions.height; row-- > 0;)
+				file.write(reinterpret_cast<const char*>(dump_pixels.data() + row * row_size), (std::streamsize)row_size);
+			if (!file)
+				throw std::runtime_error("Failed to write the frame dump " + path.string() + '.');
+		}
+
+	public:
+		// closes after the given number of frames, and dumps every dump_interval-th of them if a directory is given
+		HeadlessWindow(const Extent2D& dimensions, const u32 frame_count,
+			std::optional<std::filesystem::path> dump_directory = std::nullopt, const u32 dump_interval = 1):
+			display(EGL_NO_DISPLAY), surface(EGL_NO_SURFACE), context(EGL_NO_CONTEXT), framebuffer(0),
+			color_renderbuffer(0), depth_renderbuffer(0), dimensions(dimensions), frame_count(frame_count),
+			presented_frame_count(0), dump_directory(std::move(dump_directory)), dump_interval(std::max(1u, dump_interval))
+		{
+			display = GetDisplay();
+			if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+				throw std::runtime_error("Failed to initialize EGL.");
+			if (!eglBindAPI(EGL_OPENGL_API))
+				throw std::runtime_error("EGL does not support desktop OpenGL.");
+
+			const EGLint config_attributes[] =
+			{
+				EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+				EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+				EGL_NONE
+			};
+			EGLConfig config = nullptr;
+			EGLint config_count = 0;
+			eglChooseConfig(display, config_attributes, &config, 1, &config_count);
+
+			// same version as the GLFW windows
+			const EGLint context_attributes[] =
+			{
+				EGL_CONTEXT_MAJOR_VERSION, 4,
+				EGL_CONTEXT_MINOR_VERSION, 0,
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+				EGL_NONE
+			};
+			const bool is_surfaceless = HasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+			if (config_count == 0 && !is_surfaceless)
+				throw std::runtime_error("Failed to find an EGL configuration for OpenGL.");
+			context = eglCreateContext(display, config_count ? config : nullptr, EGL_NO_CONTEXT, context_attributes);
+			if (context == EGL_NO_CONTEXT)
+				throw std::runtime_error("Failed to create an OpenGL 4.0 core EGL context.");
+
+			// without surfaceless contexts, a tiny pbuffer is current and never drawn to
+			if (!is_surfaceless)
+			{
+				const EGLint pbuffer_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+				surface = eglCreatePbufferSurface(display, config, pbuffer_attributes);
+				if (surface == EGL_NO_SURFACE)
+					throw std::runtime_error("Failed to create an EGL pbuffer surface.");
+			}
+			if (!eglMakeCurrent(display, surface, surface, context))
+				throw std::runtime_error("Failed to make the EGL context current.");
+
+			if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+				throw std::runtime_error("Failed to initialize GLAD.");
+
+			// everything is drawn into this framebuffer, which stays bound as if it were the window's
+			glGenRenderbuffers(1, &color_renderbuffer);
+			glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, (GLsizei)dimensions.width, (GLsizei)dimensions.height);
+			glGenRenderbuffers(1, &depth_renderbuffer);
+			glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, (GLsizei)dimensions.width, (GLsizei)dimensions.height);
+			glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+			glGenFramebuffers(1, &framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_renderbuffer);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_renderbuffer);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				throw std::runtime_error("Failed to create the headless framebuffer.");
+			// there is no window to size the viewport when the context is first made current
+			glViewport(0, 0, (GLsizei)dimensions.width, (GLsizei)dimensions.height);
+
+			if (this->dump_directory)
+			{
+				std::filesystem::create_directories(*this->dump_directory);
+				dump_pixels.resize(usize(dimensions.width) * dimensions.height * 3);
+				glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			}
+		}
+
+		HeadlessWindow(const HeadlessWindow&) = delete;
+		HeadlessWindow& operator=(const HeadlessWindow&) = delete;
+
+		~HeadlessWindow()
+		{
+			glDeleteFramebuffers(1, &framebuffer);
+			glDeleteRenderbuffers(1, &color_renderbuffer);
+			glDeleteRenderbuffers(1, &depth_renderbuffer);
+			eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroyContext(display, context);
+			if (surface != EGL_NO_SURFACE)
+				eglDestroySurface(display, surface);
+			eglTerminate(display);
+		}
+
+		// there is no input, the event listener is never called
+		void SetEventListener(const WindowEventHandler*) const
+		{}
+
+		Extent2D GetViewport() const
+		{
+			return dimensions;
+		}
+
+		bool ShouldClose() const
+		{
+			return presented_frame_count >= frame_count;
+		}
+
+		void ProcessEvents() const
+		{}
+
+		// ends the frame, dumping it if it is one of the dumped frames
+		void Present()
+		{
+			NGE_PROFILE_SCOPE("HeadlessWindow::Present");
+			presented_frame_count++;
+			if (dump_directory && presented_frame_count % dump_interval == 0)
+				DumpFrame();
+			// submits the frame, as swapping buffers would
+			glFlush();
+		}
+
+		u32 GetPresentedFrameCount() const {return presented_frame_count;}
+	};
+}
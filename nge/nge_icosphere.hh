@@ -0,0 +1,210 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_graphics.hh"
+#include "nge_math.hh"
+#include "nge_mesh.hh"
+#include "types.hh"
+
+// std headers
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <memory>
+#include <numbers>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+namespace nge::graphics
+{
+	// unit sphere made by subdividing an icosahedron, each subdivision splits every triangle in 4
+	// texture coordinates are equirectangular, u going around the Y axis and v from the south to the north pole
+	// vertices are duplicated along the texture seam and at the poles, so that no triangle wraps around the texture
+	inline Mesh GenerateIcosphere(const u32 subdivision_count)
+	{
+		// icosahedron with a vertex on each pole, and two rings of 5 vertices in between
+		constexpr u32 NORTH_POLE = 0, SOUTH_POLE = 11;
+		auto is_pole = [](const u32 index) {return index == NORTH_POLE || index == SOUTH_POLE;};
+		std::vector<vec3> positions;
+		positions.emplace_back(0.0f, 1.0f, 0.0f);
+		const float ring_latitude = std::atan(0.5f);
+		for (u32 i = 0; i < 5; i++)
+		{
+			const float longitude = static_cast<float>(i) * 2.0f * std::numbers::pi_v<float> / 5.0f;
+			positions.emplace_back(std::cos(ring_latitude) * std::cos(longitude), std::sin(ring_latitude),
+				std::cos(ring_latitude) * std::sin(longitude));
+		}
+		for (u32 i = 0; i < 5; i++)
+		{
+			const float longitude = (static_cast<float>(i) + 0.5f) * 2.0f * std::numbers::pi_v<float> / 5.0f;
+			positions.emplace_back(std::cos(ring_latitude) * std::cos(longitude), -std::sin(ring_latitude),
+				std::cos(ring_latitude) * std::sin(longitude));
+		}
+		positions.emplace_back(0.0f, -1.0f, 0.0f);
+
+		// counter-clockwise seen from outside
+		std::vector<u32> triangles;
+		for (u32 i = 0; i < 5; i++)
+		{
+			const u32 upper = 1 + i, next_upper = 1 + (i + 1) % 5;
+			const u32 lower = 6 + i, next_lower = 6 + (i + 1) % 5;
+			triangles.insert(triangles.end(), {NORTH_POLE, next_upper, upper});
+			triangles.insert(triangles.end(), {upper, next_upper, lower});
+			triangles.insert(triangles.end(), {lower, next_upper, next_lower});
+			triangles.insert(triangles.end(), {SOUTH_POLE, lower, next_lower});
+		}
+
+		for (u32 subdivision = 0; subdivision < subdivision_count; subdivision++)
+		{
+			// edges are shared by two triangles, which must share their midpoint as well
+			std::unordered_map<u64, u32> midpoints;
+			auto get_midpoint = [&positions, &midpoints](const u32 a, const u32 b)
+			{
+				const u64 edge = (static_cast<u64>(std::min(a, b)) << 32) | std::max(a, b);
+				const auto [found, inserted] = midpoints.try_emplace(edge, static_cast<u32>(positions.size()));
+				if (inserted)
+					positions.push_back(normalize(positions[a] + positions[b]));
+				return found->second;
+			};
+
+			std::vector<u32> subdivided_triangles;
+			subdivided_triangles.reserve(triangles.size() * 4);
+			for (usize t = 0; t < triangles.size(); t += 3)
+			{
+				const u32 a = triangles[t], b = triangles[t + 1], c = triangles[t + 2];
+				const u32 ab = get_midpoint(a, b), bc = get_midpoint(b, c), ca = get_midpoint(c, a);
+				subdivided_triangles.insert(subdivided_triangles.end(), {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca});
+			}
+			triangles = std::move(subdivided_triangles);
+		}
+
+		auto get_u = [](const vec3& position) {return 0.5f - std::atan2(position.z, position.x) / (2.0f * std::numbers::pi_v<float>);};
+		auto get_v = [](const vec3& position) {return 0.5f + std::asin(std::clamp(position.y, -1.0f, 1.0f)) / std::numbers::pi_v<float>;};
+
+		Mesh mesh;
+		mesh.vertices.reserve(positions.size() + positions.size() / 8);
+		auto add_vertex = [&mesh](const vec3& position, const float u, const float v)
+		{
+			// direction of increasing u, which stays defined at the poles
+			const float longitude = 2.0f * std::numbers::pi_v<float> * (0.5f - u);
+			mesh.vertices.push_back({position, position, vec3(std::sin(longitude), 0.0f, -std::cos(longitude)), vec2(u, v)});
+			return static_cast<u32>(mesh.vertices.size() - 1);
+		};
+
+		for (const auto& position : positions)
+			add_vertex(position, get_u(position), get_v(position));
+		// copies of the vertices on the seam, with u shifted by one turn
+		std::unordered_map<u32, u32> wrapped_vertices;
+
+		mesh.vertex_indices.reserve(triangles.size());
+		for (usize t = 0; t < triangles.size(); t += 3)
+		{
+			std::array<u32, 3> corners = {triangles[t], triangles[t + 1], triangles[t + 2]};
+
+			// triangles crossing the seam get their low-u corners moved one turn further
+			float min_u = 1.0f, max_u = 0.0f;
+			for (const u32 corner : corners)
+			{
+				if (is_pole(corner))
+					continue; // the pole u is meaningless
+				min_u = std::min(min_u, mesh.vertices[corner].texcoord.x);
+				max_u = std::max(max_u, mesh.vertices[corner].texcoord.x);
+			}
+			if (max_u - min_u > 0.5f)
+			{
+				for (auto& corner : corners)
+				{
+					if (is_pole(corner) || mesh.vertices[corner].texcoord.x >= 0.5f)
+						continue;
+
+					const auto [found, inserted] = wrapped_vertices.try_emplace(corner, 0);
+					if (inserted)
+						found->second = add_vertex(positions[corner], mesh.vertices[corner].texcoord.x + 1.0f, mesh.vertices[corner].texcoord.y);
+					corner = found->second;
+				}
+			}
+
+			// every triangle touching a pole gets its own pole vertex, in the middle of its other corners
+			for (usize i = 0; i < corners.size(); i++)
+			{
+				if (!is_pole(triangles[t + i]))
+					continue;
+
+				const float u = (mesh.vertices[corners[(i + 1) % 3]].texcoord.x + mesh.vertices[corners[(i + 2) % 3]].texcoord.x) / 2.0f;
+				corners[i] = add_vertex(positions[triangles[t + i]], u, mesh.vertices[corners[i]].texcoord.y);
+			}
+
+			for (const u32 corner : corners)
+				mesh.vertex_indices.push_back(corner);
+		}
+		return mesh;
+	}
+
+	// icosphere models of increasing detail, and the selection of the one to draw from the size of a sphere on screen
+	class IcosphereLodChain
+	{
+	public:
+		static constexpr u32 LEVEL_COUNT = 5;
+		static constexpr u32 COARSEST_SUBDIVISION_COUNT = 1; // 80 triangles, the finest level has 20480
+
+		// the chosen level keeps the triangle edges below this length on screen
+		static constexpr float MAX_EDGE_PIXELS = 8.0f;
+		// relative change of the screen radius needed to leave a level, so that a sphere at a threshold does not flicker
+		static constexpr float HYSTERESIS = 0.15f;
+
+	private:
+		std::vector<std::unique_ptr<Model>> levels;
+		// largest screen radius for which each level is detailed enough
+		std::array<float, LEVEL_COUNT> max_screen_radii;
+
+	public:
+		IcosphereLodChain()
+		{
+			// the icosahedron edges span about 63 degrees, and each subdivision halves them
+			const float icosahedron_edge_angle = std::atan(2.0f);
+			std::vector<PackedVertexFormat> packed_vertices;
+			for (u32 level = 0; level < LEVEL_COUNT; level++)
+			{
+				const u32 subdivision_count = COARSEST_SUBDIVISION_COUNT + level;
+				Mesh mesh = GenerateIcosphere(subdivision_count);
+				OptimizeMesh(mesh);
+				// the finest levels are fetched millions of times per frame, and the unit sphere fits the packed positions
+				PackVertices(mesh.vertices, packed_vertices);
+				levels.push_back(std::make_unique<Model>(packed_vertices, mesh.vertex_indices));
+				max_screen_radii[level] = MAX_EDGE_PIXELS * static_cast<float>(1u << subdivision_count) / icosahedron_edge_angle;
+			}
+		}
+
+		// radius in pixels of a sphere seen from a camera, projection_scale being the projection matrix [1][1] element
+		static float ComputeScreenRadius(const vec3& center, const float radius, const vec3& view_position,
+			const float projection_scale, const float viewport_height)
+		{
+			const float distance = length(center - view_position);
+			if (distance <= radius)
+				return std::numeric_limits<float>::infinity(); // the camera is inside
+			return radius / distance * projection_scale * viewport_height / 2.0f;
+		}
+
+		// picks the level of a sphere from its radius in pixels, given the level it was drawn with the previous frame
+		u32 SelectLevel(const float screen_radius, const u32 current_level) const
+		{
+			u32 ideal_level = 0;
+			while (ideal_level + 1 < LEVEL_COUNT && screen_radius > max_screen_radii[ideal_level])
+				ideal_level++;
+
+			if (ideal_level > current_level && screen_radius > max_screen_radii[current_level] * (1.0f + HYSTERESIS))
+				return ideal_level;
+			if (ideal_level < current_level && screen_radius < max_screen_radii[current_level - 1] * (1.0f - HYSTERESIS))
+				return ideal_level;
+			return std::min(current_level, LEVEL_COUNT - 1);
+		}
+
+		const Model& GetLevel(const u32 level) const {return *levels[level];}
+	};
+}
@@ -0,0 +1,87 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_graphics.hh"
+#include "nge_state_cache.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+namespace nge::graphics
+{
+	// camera-facing quads whose fragments ray-trace a sphere, for bodies too small on screen to be worth a mesh
+	// they are drawn from the same instances as sphere models, so a body can switch between both from one frame to the next
+	// the matching shaders are impostor.vs and impostor.fs
+	class SphereImpostors
+	{
+		GLuint VAO;
+		GLuint VBO;
+
+	public:
+		// bodies smaller than this radius on screen, in pixels, are drawn as impostors
+		static constexpr float MAX_SCREEN_RADIUS = 8.0f;
+		// relative change of the screen radius needed to switch path, so that a body at the threshold does not flicker
+		static constexpr float HYSTERESIS = 0.15f;
+
+		SphereImpostors():
+			VAO(0), VBO(0)
+		{
+			// corners of the quad in units of the sphere's silhouette, as a triangle strip facing the camera
+			constexpr float corners[] =
+			{
+				-1.0f, -1.0f,
+				1.0f, -1.0f,
+				-1.0f, 1.0f,
+				1.0f, 1.0f,
+			};
+
+			glGenVertexArrays(1, &VAO);
+			glGenBuffers(1, &VBO);
+
+			StateCache::Current().BindVertexArray(VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			StateCache::Current().BindVertexArray(0);
+		}
+
+		SphereImpostors(const SphereImpostors&) = delete;
+		SphereImpostors& operator=(const SphereImpostors&) = delete;
+
+		~SphereImpostors()
+		{
+			glDeleteBuffers(1, &VBO);
+			glDeleteVertexArrays(1, &VAO);
+			StateCache::Current().OnVertexArrayDeleted(VAO);
+		}
+
+		// whether a body should be drawn as an impostor, given whether it was the previous frame
+		static bool ShouldUseImpostor(const float screen_radius, const bool was_impostor)
+		{
+			return was_impostor ? screen_radius < MAX_SCREEN_RADIUS * (1.0f + HYSTERESIS) :
+				screen_radius < MAX_SCREEN_RADIUS * (1.0f - HYSTERESIS);
+		}
+
+		// packet drawing one sphere per InstanceFormat instance, the caller sets its key, program, state and textures
+		DrawPacket MakeDrawPacket(const StreamAllocation& instances) const
+		{
+			DrawPacket packet;
+			packet.vertex_array = VAO;
+			packet.primitive = GL_TRIANGLE_STRIP;
+			packet.vertex_count = 4;
+			packet.instance_count = static_cast<u32>(instances.size / sizeof(InstanceFormat));
+			packet.set_instance_attributes = SetInstanceAttributes;
+			packet.instance_buffer = instances.buffer;
+			packet.instance_offset = instances.offset;
+			return packet;
+		}
+	};
+}
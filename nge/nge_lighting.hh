@@ -0,0 +1,421 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_math.hh"
+#include "nge_profiler.hh"
+#include "nge_shader.hh"
+#include "nge_state_cache.hh"
+#include "nge_streaming.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <array>
+#include <string>
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cmath>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+// SSE2 is part of every x86-64 CPU, other architectures use the scalar path
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NGE_LIGHTING_SSE2 1
+#include <emmintrin.h>
+#else
+#define NGE_LIGHTING_SSE2 0
+#endif
+
+namespace nge::graphics
+{
+	// light shining the same way in every direction, and fading out to nothing at its radius
+	struct PointLight
+	{
+		vec3 position;
+		float radius;
+		vec3 color;
+		float padding = 0.0f; // so that every light is two texels of the lights buffer
+	};
+
+	// lists of the point lights reaching each cluster of the view frustum, for clustered forward shading (Olsson,
+	// Billeter and Assarsson 2012): fragments only loop over the lights of their cluster, so their cost depends on how
+	// many lights overlap rather than on how many there are
+	// the frustum is split into CLUSTER_COUNT_X by CLUSTER_COUNT_Y tiles of the screen, and CLUSTER_COUNT_Z slices of
+	// depth growing exponentially with the distance so that clusters stay about as deep as they are wide
+	// a light is added to every cluster of the box bounding its sphere in cluster space, which is conservative
+	// shaders read the lists with ComputePointLights of shaders/lighting.glsl, given the grid by GetShaderConstants
+	class LightClusters
+	{
+	public:
+		static constexpr u32 CLUSTER_COUNT_X = 16;
+		static constexpr u32 CLUSTER_COUNT_Y = 9;
+		static constexpr u32 CLUSTER_COUNT_Z = 24;
+		static constexpr u32 CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+		// every driver can read buffer textures of 65536 texels, lights beyond it are missing from the last clusters
+		static constexpr u32 MAX_LIGHT_INDEX_COUNT = 65536;
+		// each light takes 2 texels
+		static constexpr u32 MAX_LIGHT_COUNT = MAX_LIGHT_INDEX_COUNT / 2;
+
+	private:
+		// clusters reached by a light, as inclusive ranges
+		struct ClusterBox
+		{
+			u32 light;
+			std::array<u32, 3> first;
+			std::array<u32, 3> last;
+		};
+
+		std::vector<PointLight> lights;
+		// offset in light_indices and light count of every cluster, x varying fastest then y
+		std::vector<u32> cluster_ranges;
+		std::vector<u32> light_indices;
+		float near_plane, slices_per_log_depth;
+
+		// the lights being binned, as structure of arrays
+		std::vector<float> light_x, light_y, light_z, light_radius;
+		std::vector<ClusterBox> boxes;
+
+		u32 GetSlice(const float depth) const
+		{
+			const float slice = std::log(std::max(depth, near_plane) / near_plane) * slices_per_log_depth;
+			return std::min(static_cast<u32>(slice), CLUSTER_COUNT_Z - 1);
+		}
+
+		// adds the box of the light, given the range of its sphere in view depth and in normalized device coordinates
+		void AddBox(const u32 light, const float min_depth, const float max_depth, const vec2& min_ndc, const vec2& max_ndc)
+		{
+			auto get_tile = [](const float ndc, const u32 tile_count)
+			{
+				const float tile = std::clamp((ndc * 0.5f + 0.5f) * static_cast<float>(tile_count), 0.0f,
+					static_cast<float>(tile_count - 1));
+				return static_cast<u32>(tile);
+			};
+			boxes.push_back({light, {get_tile(min_ndc.x, CLUSTER_COUNT_X), get_tile(min_ndc.y, CLUSTER_COUNT_Y), GetSlice(min_depth)},
+				{get_tile(max_ndc.x, CLUSTER_COUNT_X), get_tile(max_ndc.y, CLUSTER_COUNT_Y), GetSlice(max_depth)}});
+		}
+
+		// bins the lights of [first, last) whose sphere is in the depth range and on screen, with the scalar version of
+		// the SSE2 path
+		void BinRange(const mat4& view, const vec2& projection_scale, const float far_plane, const u32 first, const u32 last)
+		{
+			for (u32 i = first; i < last; i++)
+			{
+				const vec3 center = vec3(view * vec4(light_x[i], light_y[i], light_z[i], 1.0f));
+				const float depth = -center.z;
+				const float radius = light_radius[i];
+				if (depth + radius <= near_plane || depth - radius >= far_plane)
+					continue;
+
+				vec2 min_ndc(-1.0f), max_ndc(1.0f);
+				const float min_depth = depth - radius, max_depth = depth + radius;
+				if (min_depth > near_plane)
+				{
+					// x / depth over the box of the sphere is extreme at its corners
+					const vec2 low = (vec2(center) - radius) * projection_scale;
+					const vec2 high = (vec2(center) + radius) * projection_scale;
+					min_ndc = min(low / min_depth, low / max_depth);
+					max_ndc = max(high / min_depth, high / max_depth);
+					if (any(greaterThan(min_ndc, vec2(1.0f))) || any(lessThan(max_ndc, vec2(-1.0f))))
+						continue;
+				}
+				AddBox(i, min_depth, max_depth, min_ndc, max_ndc);
+			}
+		}
+
+	public:
+		LightClusters():
+			cluster_ranges(CLUSTER_COUNT * 2, 0), near_plane(1.0f), slices_per_log_depth(1.0f)
+		{}
+
+		// the grid as GLSL constants, placed before the code of the shaders reading the lists
+		static std::string GetShaderConstants()
+		{
+			return "const uint CLUSTER_COUNT_X = " + std::to_string(CLUSTER_COUNT_X) + "u;\n" +
+				"const uint CLUSTER_COUNT_Y = " + std::to_string(CLUSTER_COUNT_Y) + "u;\n" +
+				"const uint CLUSTER_COUNT_Z = " + std::to_string(CLUSTER_COUNT_Z) + "u;\n";
+		}
+
+		// rebuilds the lists for a camera, projection being a glm::perspective one with the given planes
+		void Build(const std::span<const PointLight> new_lights, const mat4& view, const mat4& projection,
+			const float new_near_plane, const float far_plane)
+		{
+			NGE_PROFILE_SCOPE("LightClusters::Build");
+			lights.assign(new_lights.begin(), new_lights.begin() + std::min<usize>(new_lights.size(), MAX_LIGHT_COUNT));
+			near_plane = new_near_plane;
+			slices_per_log_depth = static_cast<float>(CLUSTER_COUNT_Z) / std::log(far_plane / near_plane);
+
+			const u32 light_count = static_cast<u32>(lights.size());
+			for (auto* values : {&light_x, &light_y, &light_z, &light_radius})
+				values->resize(light_count);
+			for (u32 i = 0; i < light_count; i++)
+			{
+				light_x[i] = lights[i].position.x;
+				light_y[i] = lights[i].position.y;
+				light_z[i] = lights[i].position.z;
+				light_radius[i] = lights[i].radius;
+			}
+
+			boxes.clear();
+			const vec2 projection_scale(projection[0][0], projection[1][1]);
+			u32 i = 0;
+#if NGE_LIGHTING_SSE2
+			// view space centers and ranges of 4 lights at once, the slices need a logarithm so they are left to AddBox
+			const __m128 near_planes = _mm_set1_ps(near_plane);
+			const __m128 far_planes = _mm_set1_ps(far_plane);
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 minus_one = _mm_set1_ps(-1.0f);
+			for (; i + 4 <= light_count; i += 4)
+			{
+				const __m128 x = _mm_loadu_ps(&light_x[i]);
+				const __m128 y = _mm_loadu_ps(&light_y[i]);
+				const __m128 z = _mm_loadu_ps(&light_z[i]);
+				const __m128 radius = _mm_loadu_ps(&light_radius[i]);
+				auto transform = [&view, x, y, z](const u32 row)
+				{
+					__m128 value = _mm_mul_ps(x, _mm_set1_ps(view[0][row]));
+					value = _mm_add_ps(value, _mm_mul_ps(y, _mm_set1_ps(view[1][row])));
+					value = _mm_add_ps(value, _mm_mul_ps(z, _mm_set1_ps(view[2][row])));
+					return _mm_add_ps(value, _mm_set1_ps(view[3][row]));
+				};
+				const __m128 view_x = transform(0);
+				const __m128 view_y = transform(1);
+				const __m128 depth = _mm_sub_ps(_mm_setzero_ps(), transform(2));
+				const __m128 min_depth = _mm_sub_ps(depth, radius);
+				const __m128 max_depth = _mm_add_ps(depth, radius);
+
+				// x / depth over the box of the sphere is extreme at its corners, and spheres reaching the near plane
+				// cover the whole screen
+				auto get_range = [&](const __m128 center, const float scale, __m128& min_ndc, __m128& max_ndc)
+				{
+					const __m128 low = _mm_mul_ps(_mm_sub_ps(center, radius), _mm_set1_ps(scale));
+					const __m128 high = _mm_mul_ps(_mm_add_ps(center, radius), _mm_set1_ps(scale));
+					min_ndc = _mm_min_ps(_mm_div_ps(low, min_depth), _mm_div_ps(low, max_depth));
+					max_ndc = _mm_max_ps(_mm_div_ps(high, min_depth), _mm_div_ps(high, max_depth));
+				};
+				__m128 min_ndc_x, max_ndc_x, min_ndc_y, max_ndc_y;
+				get_range(view_x, projection_scale.x, min_ndc_x, max_ndc_x);
+				get_range(view_y, projection_scale.y, min_ndc_y, max_ndc_y);
+				const __m128 crosses_near = _mm_cmple_ps(min_depth, near_planes);
+				__m128 culled = _mm_or_ps(_mm_cmple_ps(max_depth, near_planes), _mm_cmpge_ps(min_depth, far_planes));
+				__m128 off_screen = _mm_or_ps(_mm_cmpgt_ps(min_ndc_x, one), _mm_cmplt_ps(max_ndc_x, minus_one));
+				off_screen = _mm_or_ps(off_screen, _mm_or_ps(_mm_cmpgt_ps(min_ndc_y, one), _mm_cmplt_ps(max_ndc_y, minus_one)));
+				culled = _mm_or_ps(culled, _mm_andnot_ps(crosses_near, off_screen));
+
+				alignas(16) std::array<float, 4> min_depths, max_depths, min_xs, max_xs, min_ys, max_ys;
+				auto select = [crosses_near](const __m128 value, const __m128 full_screen)
+				{
+					return _mm_or_ps(_mm_and_ps(crosses_near, full_screen), _mm_andnot_ps(crosses_near, value));
+				};
+				_mm_store_ps(min_depths.data(), min_depth);
+				_mm_store_ps(max_depths.data(), max_depth);
+				_mm_store_ps(min_xs.data(), select(min_ndc_x, minus_one));
+				_mm_store_ps(max_xs.data(), select(max_ndc_x, one));
+				_mm_store_ps(min_ys.data(), select(min_ndc_y, minus_one));
+				_mm_store_ps(max_ys.data(), select(max_ndc_y, one));
+				for (u32 kept = ~static_cast<u32>(_mm_movemask_ps(culled)) & 0xF; kept != 0; kept &= kept - 1)
+				{
+					const u32 lane = static_cast<u32>(std::countr_zero(kept));
+					AddBox(i + lane, min_depths[lane], max_depths[lane], vec2(min_xs[lane], min_ys[lane]),
+						vec2(max_xs[lane], max_ys[lane]));
+				}
+			}
+#endif
+			BinRange(view, projection_scale, far_plane, i, light_count);
+
+			// counts the lights of every cluster, then fills the lists in light order
+			std::fill(cluster_ranges.begin(), cluster_ranges.end(), 0);
+			auto for_each_cluster = [](const ClusterBox& box, auto&& function)
+			{
+				for (u32 z = box.first[2]; z <= box.last[2]; z++)
+					for (u32 y = box.first[1]; y <= box.last[1]; y++)
+						for (u32 x = box.first[0]; x <= box.last[0]; x++)
+							function((z * CLUSTER_COUNT_Y + y) * CLUSTER_COUNT_X + x);
+			};
+			for (const ClusterBox& box : boxes)
+				for_each_cluster(box, [this](const u32 cluster) {cluster_ranges[cluster * 2 + 1]++;});
+			u32 offset = 0;
+			for (u32 cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+			{
+				cluster_ranges[cluster * 2] = offset;
+				cluster_ranges[cluster * 2 + 1] = std::min(cluster_ranges[cluster * 2 + 1], MAX_LIGHT_INDEX_COUNT - offset);
+				offset += cluster_ranges[cluster * 2 + 1];
+				cluster_ranges[cluster * 2 + 1] = 0; // counted again while filling
+			}
+			light_indices.resize(offset);
+			for (const ClusterBox& box : boxes)
+			{
+				for_each_cluster(box, [this, &box](const u32 cluster)
+				{
+					// the list ends where the next one starts, which is earlier than counted once the indices are full
+					const u32 end = cluster + 1 < CLUSTER_COUNT ? cluster_ranges[cluster * 2 + 2] : static_cast<u32>(light_indices.size());
+					u32& count = cluster_ranges[cluster * 2 + 1];
+					if (cluster_ranges[cluster * 2] + count < end)
+						light_indices[cluster_ranges[cluster * 2] + count++] = box.light;
+				});
+			}
+		}
+
+		// cluster of a point in view depth and normalized device coordinates, as the shaders find it
+		u32 GetCluster(const float depth, const vec2& ndc) const
+		{
+			auto get_tile = [](const float value, const u32 tile_count)
+			{
+				return std::min(static_cast<u32>(std::max((value * 0.5f + 0.5f) * static_cast<float>(tile_count), 0.0f)),
+					tile_count - 1);
+			};
+			return (GetSlice(depth) * CLUSTER_COUNT_Y + get_tile(ndc.y, CLUSTER_COUNT_Y)) * CLUSTER_COUNT_X +
+				get_tile(ndc.x, CLUSTER_COUNT_X);
+		}
+
+		std::span<const u32> GetClusterLights(const u32 cluster) const
+		{
+			return std::span(light_indices).subspan(cluster_ranges[cluster * 2], cluster_ranges[cluster * 2 + 1]);
+		}
+
+		std::span<const PointLight> GetLights() const {return lights;}
+		std::span<const u32> GetClusterRanges() const {return cluster_ranges;}
+		std::span<const u32> GetLightIndices() const {return light_indices;}
+		float GetNearPlane() const {return near_plane;}
+		float GetSlicesPerLogDepth() const {return slices_per_log_depth;}
+	};
+
+	// buffer textures holding the lists of LightClusters for the shaders, rewritten every frame
+	// with texture buffer ranges (GL 4.3), the lists are written into the frame's region of the streaming buffer, fenced
+	// like the rest of the frame's dynamic data, and the textures point at their ranges of it
+	// the GL 4.0 context the game asks for has no glTexBufferRange though, and a buffer texture sees its whole buffer there,
+	// so the textures then own buffers which are orphaned every frame instead
+	class LightClusterBuffers
+	{
+	public:
+		// texture units of the buffers, after the ones of the planet materials
+		static constexpr u32 CLUSTERS_TEXTURE_UNIT = 3;
+		static constexpr u32 LIGHT_INDICES_TEXTURE_UNIT = 4;
+		static constexpr u32 LIGHTS_TEXTURE_UNIT = 5;
+
+	private:
+		// cluster ranges, light indices and lights
+		std::array<GLuint, 3> buffers{};
+		std::array<GLuint, 3> textures{};
+		bool is_streamed;
+		usize offset_alignment; // of texture buffer ranges
+
+		static constexpr std::array<u32, 3> TEXTURE_UNITS = {CLUSTERS_TEXTURE_UNIT, LIGHT_INDICES_TEXTURE_UNIT, LIGHTS_TEXTURE_UNIT};
+		static constexpr std::array<GLenum, 3> TEXTURE_FORMATS = {GL_RG32UI, GL_R32UI, GL_RGBA32F};
+
+		// the largest lists, once the clusters are full
+		static constexpr std::array<usize, 3> MAX_SIZES = {LightClusters::CLUSTER_COUNT * 2 * sizeof(u32),
+			LightClusters::MAX_LIGHT_INDEX_COUNT * sizeof(u32), LightClusters::MAX_LIGHT_COUNT * sizeof(PointLight)};
+		// above what any driver aligns texture buffer ranges to (256 bytes at most on current ones)
+		static constexpr usize MAX_OFFSET_ALIGNMENT = 1024;
+
+		// the buffer is orphaned, so the upload never waits for the GPU to be done with the previous frame's data
+		void Upload(const u32 index, const void* data, const usize size)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, buffers[index]);
+			glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)size, data);
+		}
+
+		void Upload(const u32 index, const void* data, const usize size, StreamingBuffer& streaming_buffer)
+		{
+			if (!is_streamed)
+				return Upload(index, data, size);
+
+			const StreamAllocation allocation = streaming_buffer.Allocate(size, offset_alignment);
+			std::memcpy(allocation.data, data, size);
+			StateCache& state_cache = StateCache::Current();
+			state_cache.BindTexture(TEXTURE_UNITS[index], GL_TEXTURE_BUFFER, textures[index]);
+			state_cache.SetActiveTexture(TEXTURE_UNITS[index]);
+			glTexBufferRange(GL_TEXTURE_BUFFER, TEXTURE_FORMATS[index], allocation.buffer, (GLintptr)allocation.offset,
+				(GLsizeiptr)allocation.size);
+		}
+
+		template<typename T>
+		void Upload(const u32 index, const std::span<const T> values, StreamingBuffer& streaming_buffer)
+		{
+			// empty buffers are not valid buffer texture storage on every driver
+			const u32 empty = 0;
+			if (values.empty())
+				Upload(index, &empty, sizeof(empty), streaming_buffer);
+			else
+				Upload(index, values.data(), values.size_bytes(), streaming_buffer);
+		}
+
+	public:
+		// the most bytes a frame allocates from the streaming buffer
+		static constexpr usize MAX_STREAMED_SIZE = MAX_SIZES[0] + MAX_SIZES[1] + MAX_SIZES[2] + 3 * MAX_OFFSET_ALIGNMENT;
+
+		// allow_streaming can turn the streaming buffer off, to orphan on drivers which have texture buffer ranges as well
+		explicit LightClusterBuffers(const bool allow_streaming = true):
+			is_streamed(false), offset_alignment(0)
+		{
+			// the loader only knows the core function, so the extension alone on an older context is not enough
+			if (allow_streaming && GLAD_GL_VERSION_4_3 && glTexBufferRange)
+			{
+				GLint alignment = 0;
+				glGetIntegerv(GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+				offset_alignment = std::max<usize>(alignment, 16);
+				if (offset_alignment > MAX_OFFSET_ALIGNMENT)
+					throw std::runtime_error("Texture buffer ranges are aligned to more than the light clusters expect.");
+				is_streamed = true;
+			}
+
+			glGenTextures(3, textures.data());
+			if (is_streamed)
+				return; // the textures get their storage with the first upload
+
+			glGenBuffers(3, buffers.data());
+			const u32 empty = 0;
+			for (u32 i = 0; i < 3; i++)
+			{
+				Upload(i, &empty, sizeof(empty));
+				StateCache::Current().BindTexture(TEXTURE_UNITS[i], GL_TEXTURE_BUFFER, textures[i]);
+				glTexBuffer(GL_TEXTURE_BUFFER, TEXTURE_FORMATS[i], buffers[i]);
+			}
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		}
+
+		LightClusterBuffers(const LightClusterBuffers&) = delete;
+		LightClusterBuffers& operator=(const LightClusterBuffers&) = delete;
+
+		~LightClusterBuffers()
+		{
+			glDeleteTextures(3, textures.data());
+			if (!is_streamed)
+				glDeleteBuffers(3, buffers.data());
+		}
+
+		// points the samplers of a program shading with the clusters (with ComputePointLights) at the textures
+		static void SetSamplers(const Shader& shader)
+		{
+			shader.Use();
+			shader.SetUniform(shader.GetUniform("light_clusters"), static_cast<s32>(CLUSTERS_TEXTURE_UNIT));
+			shader.SetUniform(shader.GetUniform("light_indices"), static_cast<s32>(LIGHT_INDICES_TEXTURE_UNIT));
+			shader.SetUniform(shader.GetUniform("lights"), static_cast<s32>(LIGHTS_TEXTURE_UNIT));
+		}
+
+		// uploads the lists and binds the textures to their units for the rest of the frame
+		// to be called between BeginFrame and Flush of the streaming buffer, which then holds the lists until EndFrame
+		void Upload(const LightClusters& clusters, StreamingBuffer& streaming_buffer)
+		{
+			NGE_PROFILE_SCOPE("LightClusterBuffers::Upload");
+			Upload(0, clusters.GetClusterRanges(), streaming_buffer);
+			Upload(1, clusters.GetLightIndices(), streaming_buffer);
+			Upload(2, clusters.GetLights(), streaming_buffer);
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+			for (u32 i = 0; i < 3; i++)
+				StateCache::Current().BindTexture(TEXTURE_UNITS[i], GL_TEXTURE_BUFFER, textures[i]);
+		}
+
+		bool IsStreamed() const {return is_streamed;}
+	};
+}
@@ -14,6 +14,7 @@ using namespace glm;
 namespace nge::math
 {
 	using Vector3 = glm::vec3;
+	using Vector3d = glm::dvec3;
 	using Vector4 = glm::vec4;
 	using Matrix4 = glm::mat4;
 }
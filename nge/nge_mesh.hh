@@ -0,0 +1,288 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_graphics.hh"
+#include "nge_math.hh"
+#include "types.hh"
+
+// std headers
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <limits>
+
+namespace nge::graphics
+{
+	// triangle mesh, ready to be turned into a Model
+	struct Mesh
+	{
+		std::vector<VertexFormat> vertices;
+		std::vector<u32> vertex_indices;
+	};
+
+	// entries of the post-transform vertex cache the triangle orders are made for, GPUs having at least as many
+	static constexpr u32 VERTEX_CACHE_SIZE = 16;
+
+	// average number of vertices transformed per triangle (ACMR) with a FIFO post-transform cache of the given size,
+	// down to about 0.5 for the best orders of large meshes, and up to 3 when no vertex is ever reused
+	inline float AnalyzeVertexCache(const std::span<const u32> vertex_indices, const u32 vertex_count,
+		const u32 cache_size = VERTEX_CACHE_SIZE)
+	{
+		if (vertex_indices.size() < 3)
+			return 0.0f;
+
+		// a vertex is cached while fewer than cache_size misses happened since its own
+		std::vector<u32> cache_times(vertex_count, 0);
+		u32 time = cache_size + 1;
+		for (const u32 index : vertex_indices)
+		{
+			if (time - cache_times[index] > cache_size)
+				cache_times[index] = time++;
+		}
+		return static_cast<float>(time - cache_size - 1) / static_cast<float>(vertex_indices.size() / 3);
+	}
+
+	// reorders the triangles for the post-transform vertex cache with Tipsify (Sander, Nehab and Barczak 2007), in
+	// linear time: it emits every triangle around one vertex at a time, then moves on to one of their vertices which will
+	// still be cached once its own triangles are emitted, and only jumps elsewhere when there is none
+	// the corners of every triangle keep their order, so the winding is unchanged
+	// returns the first triangle of every run that started with such a jump, which OptimizeOverdraw reorders
+	inline std::vector<u32> OptimizeVertexCache(const std::span<u32> vertex_indices, const u32 vertex_count,
+		const u32 cache_size = VERTEX_CACHE_SIZE)
+	{
+		constexpr u32 NONE = std::numeric_limits<u32>::max();
+		const u32 triangle_count = static_cast<u32>(vertex_indices.size() / 3);
+		std::vector<u32> restarts;
+		if (triangle_count == 0)
+			return restarts;
+
+		// triangles of every vertex, and how many of them are left to emit
+		std::vector<u32> live_counts(vertex_count, 0);
+		for (const u32 index : vertex_indices)
+			live_counts[index]++;
+		std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+		for (u32 vertex = 0; vertex < vertex_count; vertex++)
+			adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + live_counts[vertex];
+		std::vector<u32> adjacency(triangle_count * 3);
+		std::vector<u32> next_adjacent(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (u32 i = 0; i < triangle_count * 3; i++)
+			adjacency[next_adjacent[vertex_indices[i]]++] = i / 3;
+
+		std::vector<u32> cache_times(vertex_count, 0);
+		u32 time = cache_size + 1;
+		std::vector<bool> emitted(triangle_count, false);
+		std::vector<u32> optimized;
+		optimized.reserve(triangle_count * 3);
+		// vertices of the emitted triangles, the latest on top, to restart from the most recent ones at dead ends
+		std::vector<u32> dead_ends;
+		std::vector<u32> candidates;
+		u32 cursor = 0; // no vertex before it has triangles left
+
+		auto find_restart = [&]()
+		{
+			while (!dead_ends.empty())
+			{
+				const u32 vertex = dead_ends.back();
+				dead_ends.pop_back();
+				if (live_counts[vertex] > 0)
+					return vertex;
+			}
+			for (; cursor < vertex_count; cursor++)
+			{
+				if (live_counts[cursor] > 0)
+					return cursor;
+			}
+			return NONE;
+		};
+
+		u32 fanning = find_restart();
+		restarts.push_back(0);
+		while (fanning != NONE)
+		{
+			candidates.clear();
+			for (u32 a = adjacency_offsets[fanning]; a < adjacency_offsets[fanning + 1]; a++)
+			{
+				const u32 triangle = adjacency[a];
+				if (emitted[triangle])
+					continue;
+
+				emitted[triangle] = true;
+				for (u32 corner = 0; corner < 3; corner++)
+				{
+					const u32 vertex = vertex_indices[triangle * 3 + corner];
+					optimized.push_back(vertex);
+					dead_ends.push_back(vertex);
+					candidates.push_back(vertex);
+					live_counts[vertex]--;
+					if (time - cache_times[vertex] > cache_size)
+						cache_times[vertex] = time++;
+				}
+			}
+
+			// the oldest candidate which stays cached while its remaining triangles, of 2 new vertices at most each, are
+			// emitted, or failing that any candidate with triangles left
+			u32 next = NONE;
+			u32 next_priority = 0;
+			for (const u32 vertex : candidates)
+			{
+				if (live_counts[vertex] == 0)
+					continue;
+
+				const u32 age = time - cache_times[vertex];
+				const u32 priority = age + 2 * live_counts[vertex] <= cache_size ? age : 0;
+				if (next == NONE || priority > next_priority)
+				{
+					next = vertex;
+					next_priority = priority;
+				}
+			}
+			if (next == NONE)
+			{
+				next = find_restart();
+				if (next != NONE)
+					restarts.push_back(static_cast<u32>(optimized.size() / 3));
+			}
+			fanning = next;
+		}
+
+		std::copy(optimized.begin(), optimized.end(), vertex_indices.begin());
+		return restarts;
+	}
+
+	// reorders clusters of triangles so that the ones which face away from the center of the mesh, and tend to hide the
+	// others, are drawn first (Sander, Nehab and Barczak 2007), from the runs returned by OptimizeVertexCache
+	// the runs are split further wherever their vertex cache efficiency so far is within threshold of the mesh's, since
+	// the next cluster starts with a cold cache, so that the order of smaller clusters can be chosen
+	inline void OptimizeOverdraw(Mesh& mesh, const std::span<const u32> restarts, const float threshold = 1.05f,
+		const u32 cache_size = VERTEX_CACHE_SIZE)
+	{
+		const u32 vertex_count = static_cast<u32>(mesh.vertices.size());
+		const u32 triangle_count = static_cast<u32>(mesh.vertex_indices.size() / 3);
+		if (triangle_count == 0)
+			return;
+
+		const float mesh_acmr = AnalyzeVertexCache(mesh.vertex_indices, vertex_count, cache_size);
+		std::vector<u32> cluster_starts;
+		std::vector<u32> cache_times(vertex_count, 0);
+		u32 time = cache_size + 1;
+		for (usize r = 0; r < restarts.size(); r++)
+		{
+			const u32 end = r + 1 < restarts.size() ? restarts[r + 1] : triangle_count;
+			u32 cluster_start = restarts[r];
+			u32 cluster_misses = 0;
+			time += cache_size + 1; // empties the cache
+			cluster_starts.push_back(cluster_start);
+			for (u32 triangle = restarts[r]; triangle < end; triangle++)
+			{
+				for (u32 corner = 0; corner < 3; corner++)
+				{
+					const u32 vertex = mesh.vertex_indices[triangle * 3 + corner];
+					if (time - cache_times[vertex] > cache_size)
+					{
+						cache_times[vertex] = time++;
+						cluster_misses++;
+					}
+				}
+
+				const u32 cluster_triangle_count = triangle + 1 - cluster_start;
+				if (triangle + 1 < end &&
+					static_cast<float>(cluster_misses) <= threshold * mesh_acmr * static_cast<float>(cluster_triangle_count))
+				{
+					cluster_start = triangle + 1;
+					cluster_misses = 0;
+					time += cache_size + 1;
+					cluster_starts.push_back(cluster_start);
+				}
+			}
+		}
+		if (cluster_starts.size() < 2)
+			return;
+
+		// area weighted centroids and normals, the cross product of two edges being twice the area along the normal
+		struct Cluster
+		{
+			u32 first, end;
+			vec3 centroid;
+			vec3 normal;
+			float area;
+			float sort_value;
+		};
+		std::vector<Cluster> clusters;
+		clusters.reserve(cluster_starts.size());
+		vec3 mesh_centroid(0.0f);
+		float mesh_area = 0.0f;
+		for (usize c = 0; c < cluster_starts.size(); c++)
+		{
+			Cluster cluster{cluster_starts[c], c + 1 < cluster_starts.size() ? cluster_starts[c + 1] : triangle_count,
+				vec3(0.0f), vec3(0.0f), 0.0f, 0.0f};
+			for (u32 triangle = cluster.first; triangle < cluster.end; triangle++)
+			{
+				const vec3& a = mesh.vertices[mesh.vertex_indices[triangle * 3]].position;
+				const vec3& b = mesh.vertices[mesh.vertex_indices[triangle * 3 + 1]].position;
+				const vec3& c = mesh.vertices[mesh.vertex_indices[triangle * 3 + 2]].position;
+				const vec3 normal = cross(b - a, c - a);
+				const float area = length(normal);
+				cluster.centroid += (a + b + c) / 3.0f * area;
+				cluster.normal += normal;
+				cluster.area += area;
+			}
+			mesh_centroid += cluster.centroid;
+			mesh_area += cluster.area;
+			if (cluster.area > 0.0f)
+				cluster.centroid /= cluster.area;
+			clusters.push_back(cluster);
+		}
+		if (mesh_area > 0.0f)
+			mesh_centroid /= mesh_area;
+
+		for (Cluster& cluster : clusters)
+		{
+			const float normal_length = length(cluster.normal);
+			cluster.sort_value = normal_length > 0.0f ? dot(cluster.centroid - mesh_centroid, cluster.normal / normal_length) : 0.0f;
+		}
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b)
+		{
+			return a.sort_value > b.sort_value;
+		});
+
+		std::vector<u32> sorted_indices;
+		sorted_indices.reserve(mesh.vertex_indices.size());
+		for (const Cluster& cluster : clusters)
+			sorted_indices.insert(sorted_indices.end(), mesh.vertex_indices.begin() + cluster.first * 3,
+				mesh.vertex_indices.begin() + cluster.end * 3);
+		mesh.vertex_indices = std::move(sorted_indices);
+	}
+
+	// renumbers the vertices in the order the triangles first use them, so that vertex fetching walks memory forwards
+	// vertices no triangle uses are dropped
+	inline void OptimizeVertexFetch(Mesh& mesh)
+	{
+		constexpr u32 UNUSED = std::numeric_limits<u32>::max();
+		std::vector<u32> remap(mesh.vertices.size(), UNUSED);
+		std::vector<VertexFormat> vertices;
+		vertices.reserve(mesh.vertices.size());
+		for (u32& index : mesh.vertex_indices)
+		{
+			if (remap[index] == UNUSED)
+			{
+				remap[index] = static_cast<u32>(vertices.size());
+				vertices.push_back(mesh.vertices[index]);
+			}
+			index = remap[index];
+		}
+		mesh.vertices = std::move(vertices);
+	}
+
+	// all the optimizations, in the order they must run, for meshes made or loaded at run time
+	inline void OptimizeMesh(Mesh& mesh)
+	{
+		const auto restarts = OptimizeVertexCache(mesh.vertex_indices, static_cast<u32>(mesh.vertices.size()));
+		OptimizeOverdraw(mesh, restarts);
+		OptimizeVertexFetch(mesh);
+	}
+}
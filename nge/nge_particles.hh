@@ -0,0 +1,139 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_math.hh"
+#include "nge_timing.hh"
+#include "types.hh"
+
+// std headers
+#include <vector>
+#include <initializer_list>
+
+// SSE2 is part of every x86-64 CPU, other architectures use the scalar path
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NGE_PARTICLES_SSE2 1
+#include <emmintrin.h>
+#else
+#define NGE_PARTICLES_SSE2 0
+#endif
+
+namespace nge
+{
+	// particles of one emitter simulated on the CPU, laid out as structure of arrays so that several move at once
+	// the alive particles are always the first ones: a spawned particle is appended, and a dying one is replaced by the
+	// last alive particle, so spawning never searches for a free slot and only alive particles are ever touched
+	// pools share nothing, so every emitter can have its own and update it on any thread
+	class ParticlePool
+	{
+		std::vector<float> position_x, position_y, position_z;
+		std::vector<float> velocity_x, velocity_y, velocity_z;
+		std::vector<float> life; // in seconds, the particle dies once it is down to zero
+		u32 capacity;
+		u32 alive_count;
+
+		void Kill(const u32 index)
+		{
+			const u32 last = --alive_count;
+			position_x[index] = position_x[last];
+			position_y[index] = position_y[last];
+			position_z[index] = position_z[last];
+			velocity_x[index] = velocity_x[last];
+			velocity_y[index] = velocity_y[last];
+			velocity_z[index] = velocity_z[last];
+			life[index] = life[last];
+		}
+
+	public:
+		explicit ParticlePool(const u32 capacity):
+			capacity(capacity), alive_count(0)
+		{
+			for (auto* values : {&position_x, &position_y, &position_z, &velocity_x, &velocity_y, &velocity_z, &life})
+				values->resize(capacity);
+		}
+
+		// adds a particle, unless all of them are alive already (in which case the capacity should be raised)
+		bool Spawn(const vec3& position, const vec3& velocity, const float particle_life)
+		{
+			if (alive_count == capacity)
+				return false;
+
+			const u32 index = alive_count++;
+			position_x[index] = position.x;
+			position_y[index] = position.y;
+			position_z[index] = position.z;
+			velocity_x[index] = velocity.x;
+			velocity_y[index] = velocity.y;
+			velocity_z[index] = velocity.z;
+			life[index] = particle_life;
+			return true;
+		}
+
+		// ages and moves the alive particles of [first, last), slowing them down as they go
+		// disjoint ranges can be integrated on different threads at once, before a single RemoveDead
+		void Integrate(const timing::Seconds time, const u32 first, const u32 last)
+		{
+			u32 i = first;
+#if NGE_PARTICLES_SSE2
+			const __m128 delta = _mm_set1_ps(time);
+			const __m128 damping = _mm_set1_ps(1.0f - time);
+			for (; i + 4 <= last; i += 4)
+			{
+				// the dead ones move too, they are removed right after anyway
+				_mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]), delta));
+				const auto move = [i, delta, damping](float* position, float* velocity)
+				{
+					const __m128 new_velocity = _mm_mul_ps(_mm_loadu_ps(velocity + i), damping);
+					_mm_storeu_ps(velocity + i, new_velocity);
+					_mm_storeu_ps(position + i, _mm_sub_ps(_mm_loadu_ps(position + i), _mm_mul_ps(new_velocity, delta)));
+				};
+				move(position_x.data(), velocity_x.data());
+				move(position_y.data(), velocity_y.data());
+				move(position_z.data(), velocity_z.data());
+			}
+#endif
+			for (; i < last; i++)
+			{
+				life[i] -= time;
+				velocity_x[i] *= 1.0f - time;
+				velocity_y[i] *= 1.0f - time;
+				velocity_z[i] *= 1.0f - time;
+				position_x[i] -= velocity_x[i] * time;
+				position_y[i] -= velocity_y[i] * time;
+				position_z[i] -= velocity_z[i] * time;
+			}
+		}
+
+		// replaces every particle that died with the last alive one, to be called once every range was integrated
+		void RemoveDead()
+		{
+			for (u32 i = 0; i < alive_count;)
+			{
+				if (life[i] > 0.0f)
+					i++;
+				else
+					Kill(i); // the replacement is checked next
+			}
+		}
+
+		void Update(const timing::Seconds time)
+		{
+			Integrate(time, 0, alive_count);
+			RemoveDead();
+		}
+
+		void Clear() {alive_count = 0;}
+
+		u32 GetCapacity() const {return capacity;}
+		u32 GetAliveCount() const {return alive_count;}
+
+		// state of an alive particle, whose index changes whenever a particle before it dies
+		vec3 GetPosition(const u32 index) const {return vec3(position_x[index], position_y[index], position_z[index]);}
+		vec3 GetVelocity(const u32 index) const {return vec3(velocity_x[index], velocity_y[index], velocity_z[index]);}
+		float GetLife(const u32 index) const {return life[index];}
+	};
+}
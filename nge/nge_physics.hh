@@ -13,6 +13,10 @@
 // std headers
 #include <vector> // TEMPORARY, until we get nge::memory working
 #include <functional>
+#include <span>
+#include <cmath>
+#include <string>
+#include <stdexcept>
 
 namespace nge::physics
 {
@@ -44,9 +48,27 @@ namespace nge::physics
 	};
 #endif
 
+	// what happens when two bodies touch each other
+	enum class CollisionResponse
+	{
+		Elastic,	// bodies bounce off each other
+		Accretion,	// the lighter body is absorbed by the heavier one
+	};
+
+	// how bodies are advanced in time, from the cheapest to the most accurate
+	enum class Integrator
+	{
+		ExplicitEuler,		// first order, energy grows without bounds on orbits
+		SemiImplicitEuler,	// first order but symplectic, energy error stays bounded
+		VelocityVerlet,		// second order and symplectic, one gravity evaluation per step, plus one on the first step and after bodies are added, removed or merged
+	};
+
 	class Body
 	{
+		friend class Simulation;
+
 		math::Vector3 location, velocity, force;
+		math::Vector3 field_acceleration; // acceleration due to mutual gravity, recomputed every tick
 		// TODO: inertia?
 		Kilogram inv_mass;
 
@@ -55,25 +77,43 @@ namespace nge::physics
 		bool is_static;
 
 	public:
-		constexpr Body(const math::Vector3& location, const Kilogram mass, const Meter sphere_radius, bool is_static = false):
-			location(location), velocity(), force(EARTH_GRAVITY_FORCE), inv_mass(1.0f / mass), radius(sphere_radius), is_static(is_static)
+		Body(const math::Vector3& location, const Kilogram mass, const Meter sphere_radius, bool is_static = false):
+			location(location), velocity(), force(EARTH_GRAVITY_FORCE), field_acceleration(), inv_mass(1.0f / mass),
+			radius(sphere_radius), is_static(is_static)
 		{}
 
 		const math::Vector3& GetLocation() const {return location;}
-//		float GetCollisionRadius() const {return collision.radius;}
+		const math::Vector3& GetVelocity() const {return velocity;}
+		const math::Vector3& GetForce() const {return force;}
+		Kilogram GetMass() const {return 1.0f / inv_mass;}
+		Meter GetRadius() const {return radius;}
 
 		bool IsStatic() const {return is_static;}
 
-		virtual void Integrate(const timing::Seconds time_step)
+		// updates the velocity from the current acceleration
+		void Kick(const timing::Seconds time_step)
 		{
 			if (is_static)
 				return;
 
-			const math::Vector3 body_acceleration = force * inv_mass;
-
-			// perform Euler integration (more error-prone, but fastest)
+			const math::Vector3 body_acceleration = force * inv_mass + field_acceleration;
 			velocity += body_acceleration * time_step;
+		}
+
+		// updates the location from the current velocity
+		void Drift(const timing::Seconds time_step)
+		{
+			if (is_static)
+				return;
+
 			location += velocity * time_step;
+		}
+
+		virtual void Integrate(const timing::Seconds time_step)
+		{
+			// perform semi-implicit Euler integration (more error-prone, but fastest)
+			Kick(time_step);
+			Drift(time_step);
 
 //			force = math::Vector3(0.0f);
 		}
@@ -117,12 +157,53 @@ namespace nge::physics
 			if (!other.IsStatic())
 				other.velocity += other.inv_mass * impulse;
 		}
+
+		// absorbs the other body, conserving the total mass, linear momentum and volume
+		void MergeWith(const Body& other)
+		{
+			const Kilogram mass = GetMass();
+			const Kilogram other_mass = other.GetMass();
+			const Kilogram merged_mass = mass + other_mass;
+
+			if (other.is_static)
+			{
+				// a static body never moves, so it keeps pinning the merged body in place
+				location = other.location;
+				velocity = math::Vector3(0.0f);
+				is_static = true;
+			}
+			else if (!is_static)
+			{
+				location = (location * mass + other.location * other_mass) / merged_mass;
+				velocity = (velocity * mass + other.velocity * other_mass) / merged_mass;
+			}
+
+			// the external forces of both bodies now act on the merged one
+			force += other.force;
+			inv_mass = 1.0f / merged_mass;
+			radius = std::cbrt(radius * radius * radius + other.radius * other.radius * other.radius);
+		}
 	};
 
 	class Simulation
 	{
+		static constexpr usize INVALID_INDEX = ~usize(0);
+
 		std::vector<Body> spherical_bodies;
+		std::vector<ID> body_ids; // ID of every body in spherical_bodies, at the same index
+		std::vector<usize> body_indices; // index in spherical_bodies of every body ID ever given out
 		std::vector<std::pair<Body*, Body*>> potential_collisions;
+		std::vector<bool> absorbed_bodies; // bodies merged into another one during the current tick
+
+		CollisionResponse collision_response = CollisionResponse::Elastic;
+		Integrator integrator = Integrator::SemiImplicitEuler;
+
+		float gravitational_constant = 0.0f;
+		Meter softening_length = 0.0f;
+		bool field_accelerations_current = false; // do the bodies' accelerations match their current locations?
+
+		u64 tick_count = 0;
+		timing::Seconds elapsed_time = 0.0f;
 
 		using ImpactCallback = std::function<void(Body*, Body*)>;
 		ImpactCallback impact_callback;
@@ -130,38 +211,55 @@ namespace nge::physics
 		// perform the actual dynamics
 		void UpdateDynamics(const timing::Seconds time_step)
 		{
-			// update every body state
-			for (auto& body : spherical_bodies)
-			{
-				body.Integrate(time_step);
-			}
+			// velocity Verlet reuses the accelerations computed at the end of the previous step
+			if (integrator == Integrator::VelocityVerlet && !field_accelerations_current)
+				ComputeMutualGravity(spherical_bodies, gravitational_constant, softening_length);
+
+			IntegrateBodies(spherical_bodies, time_step, integrator, gravitational_constant, softening_length);
+			field_accelerations_current = integrator == Integrator::VelocityVerlet;
 		}
 
 		void CachePotentialCollisions()
 		{
-			// TODO: to reduce the number of pairs to check, we could implement spatial partitioning
-			// using a grid or an octree
-			for (auto& body_a : spherical_bodies)
-			{
-				for (auto& body_b : spherical_bodies)
-				{
-					// skip same body
-					if (&body_a == &body_b)
-						continue;
-
-					if (body_a.IsCollidingWith(body_b))
-						potential_collisions.emplace_back(&body_a, &body_b);
-				}
-			}
+			FindPotentialCollisions(spherical_bodies, potential_collisions);
 		}
 
 		void PerformCollisionResponse(const timing::Seconds time_step)
 		{
+			if (collision_response == CollisionResponse::Accretion)
+				absorbed_bodies.assign(spherical_bodies.size(), false);
+
 			for (auto& pair : potential_collisions)
 			{
 				auto& body_a = pair.first;
 				auto& body_b = pair.second;
 
+				if (collision_response == CollisionResponse::Accretion)
+				{
+					// a body can only be absorbed once per tick, any other contact is handled on the next one
+					const usize index_a = body_a - spherical_bodies.data();
+					const usize index_b = body_b - spherical_bodies.data();
+					if (absorbed_bodies[index_a] || absorbed_bodies[index_b])
+						continue;
+
+					// trigger a callback if there is one, while both bodies still exist
+					if (impact_callback)
+						impact_callback(body_a, body_b);
+
+					// the heavier body survives, so that the sun never ends up inside of an asteroid
+					if (body_b->GetMass() > body_a->GetMass())
+					{
+						body_b->MergeWith(*body_a);
+						absorbed_bodies[index_a] = true;
+					}
+					else
+					{
+						body_a->MergeWith(*body_b);
+						absorbed_bodies[index_b] = true;
+					}
+					continue;
+				}
+
 				// react to collision
 				body_a->PerformCollisionResponse(*body_b);
 
@@ -170,31 +268,189 @@ namespace nge::physics
 					impact_callback(body_a, body_b);
 			}
 			potential_collisions.clear();
+
+			if (collision_response == CollisionResponse::Accretion)
+				RemoveAbsorbedBodies();
+		}
+
+		// swap-remove every absorbed body, which keeps the body array dense and shrinks N
+		void RemoveAbsorbedBodies()
+		{
+			for (usize index = spherical_bodies.size(); index-- > 0;)
+			{
+				if (!absorbed_bodies[index])
+					continue;
+
+				const usize last_index = spherical_bodies.size() - 1;
+				body_indices[body_ids[index]] = INVALID_INDEX;
+				if (index != last_index)
+				{
+					spherical_bodies[index] = spherical_bodies[last_index];
+					body_ids[index] = body_ids[last_index];
+					body_indices[body_ids[index]] = index;
+				}
+				spherical_bodies.pop_back();
+				body_ids.pop_back();
+				field_accelerations_current = false;
+			}
+		}
+
+		// index of a body in spherical_bodies, IDs kept across ticks may belong to bodies absorbed since
+		usize GetBodyIndex(const ID id) const
+		{
+			if (!IsBodyAlive(id))
+				throw std::runtime_error("Body " + std::to_string(id) + " was absorbed by another one, or never existed.");
+			return body_indices[id];
 		}
 
 	public:
+		// the individual simulation stages are exposed so they can be benchmarked and reused on their own
+
+		// accumulates the pull every body exerts on every other body (direct summation)
+		static void ComputeMutualGravity(const std::span<Body> bodies, const float constant, const Meter softening)
+		{
+			for (auto& body : bodies)
+				body.field_acceleration = math::Vector3(0.0f);
+
+			// mutual gravity is disabled as long as the gravitational constant is zero
+			if (constant == 0.0f)
+				return;
+
+			// Plummer softening keeps the pull finite when two bodies get very close
+			const float softening_squared = softening * softening;
+			const usize body_count = bodies.size();
+			for (usize a = 0; a < body_count; a++)
+			{
+				Body& body_a = bodies[a];
+				for (usize b = a + 1; b < body_count; b++)
+				{
+					Body& body_b = bodies[b];
+					const math::Vector3 a_to_b = body_b.location - body_a.location;
+					const float distance_squared = glm::dot(a_to_b, a_to_b) + softening_squared;
+					const float inv_distance = 1.0f / std::sqrt(distance_squared);
+					const math::Vector3 pull = constant * inv_distance * inv_distance * inv_distance * a_to_b;
+					body_a.field_acceleration += pull * body_b.GetMass();
+					body_b.field_acceleration -= pull * body_a.GetMass();
+				}
+			}
+		}
+
+		// advances every body state by one time step, evaluating mutual gravity as often as the integrator needs
+		// velocity Verlet expects the accelerations to match the current locations, and leaves them that way
+		static void IntegrateBodies(const std::span<Body> bodies, const timing::Seconds time_step,
+			const Integrator integrator = Integrator::SemiImplicitEuler, const float gravitational_constant = 0.0f,
+			const Meter softening = 0.0f)
+		{
+			switch (integrator)
+			{
+			case Integrator::ExplicitEuler:
+				ComputeMutualGravity(bodies, gravitational_constant, softening);
+				for (auto& body : bodies)
+				{
+					body.Drift(time_step);
+					body.Kick(time_step);
+				}
+				break;
+			case Integrator::SemiImplicitEuler:
+				ComputeMutualGravity(bodies, gravitational_constant, softening);
+				for (auto& body : bodies)
+					body.Integrate(time_step);
+				break;
+			case Integrator::VelocityVerlet:
+				// kick-drift-kick leapfrog
+				for (auto& body : bodies)
+				{
+					body.Kick(0.5f * time_step);
+					body.Drift(time_step);
+				}
+				ComputeMutualGravity(bodies, gravitational_constant, softening);
+				for (auto& body : bodies)
+					body.Kick(0.5f * time_step);
+				break;
+			}
+		}
+
+		// appends every pair of overlapping bodies (brute-force broadphase)
+		static void FindPotentialCollisions(const std::span<Body> bodies, std::vector<std::pair<Body*, Body*>>& collisions)
+		{
+			// TODO: to reduce the number of pairs to check, we could implement spatial partitioning
+			// using a grid or an octree
+			const usize body_count = bodies.size();
+			for (usize a = 0; a < body_count; a++)
+			{
+				// every pair is only visited once
+				for (usize b = a + 1; b < body_count; b++)
+				{
+					if (bodies[a].IsCollidingWith(bodies[b]))
+						collisions.emplace_back(&bodies[a], &bodies[b]);
+				}
+			}
+		}
+
 		void Reset()
 		{
 			spherical_bodies.clear();
+			body_ids.clear();
+			body_indices.clear();
 			potential_collisions.clear();
+			field_accelerations_current = false;
+			tick_count = 0;
+			elapsed_time = 0.0f;
 		}
 
 		void SetImpactCallback(const ImpactCallback& callback) {impact_callback = callback;}
 
+		void SetCollisionResponse(const CollisionResponse response) {collision_response = response;}
+
+		void SetIntegrator(const Integrator new_integrator) {integrator = new_integrator;}
+
+		// enables the pull between every pair of bodies, softened by the given length to avoid singularities
+		void SetMutualGravity(const float constant, const Meter softening = 0.0f)
+		{
+			gravitational_constant = constant;
+			softening_length = softening;
+			field_accelerations_current = false;
+		}
+
+		float GetGravitationalConstant() const {return gravitational_constant;}
+		Meter GetSofteningLength() const {return softening_length;}
+
 		ID AddSphericalBody(const math::Vector3& location, const Kilogram mass, const Meter radius, bool is_static = false)
 		{
-			const ID id = spherical_bodies.size();
+			const ID id = body_indices.size();
+			body_indices.push_back(spherical_bodies.size());
+			body_ids.push_back(id);
 			spherical_bodies.emplace_back(location, mass, radius, is_static);
+			field_accelerations_current = false;
 			return id;
 		}
 
+		void SetBodyVelocity(const ID id, const math::Vector3& velocity) {spherical_bodies[GetBodyIndex(id)].velocity = velocity;}
+
+		// replaces the constant external force acting on a body (the earth's gravity by default)
+		void SetBodyForce(const ID id, const math::Vector3& force) {spherical_bodies[GetBodyIndex(id)].force = force;}
+
 		void Tick(const timing::Seconds time_step = 1.0f/30.0f)
 		{
 			UpdateDynamics(time_step);
 			CachePotentialCollisions();
 			PerformCollisionResponse(time_step);
+
+			tick_count++;
+			elapsed_time += time_step;
 		}
 
-		const math::Vector3& GetBodyLocation(const ID id) const {return spherical_bodies[id].GetLocation();}
+		u64 GetTickCount() const {return tick_count;}
+		timing::Seconds GetElapsedTime() const {return elapsed_time;}
+
+		// number of bodies still being simulated
+		usize GetBodyCount() const {return spherical_bodies.size();}
+
+		// a body stops existing once it has been absorbed by another one
+		bool IsBodyAlive(const ID id) const {return id < body_indices.size() && body_indices[id] != INVALID_INDEX;}
+
+		const math::Vector3& GetBodyLocation(const ID id) const {return spherical_bodies[GetBodyIndex(id)].GetLocation();}
+		const Body& GetBody(const ID id) const {return spherical_bodies[GetBodyIndex(id)];}
+		std::span<const Body> GetBodies() const {return spherical_bodies;}
 	};
 }
@@ -0,0 +1,221 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// our headers
+#include "nge_physics.hh"
+#include "types.hh"
+
+// std headers
+#include <vector>
+#include <span>
+#include <thread>
+#include <fstream>
+#include <string_view>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace nge::physics
+{
+	// quantities that an isolated system conserves, used to measure how much the integration drifts
+	struct ConservedQuantities
+	{
+		double kinetic_energy = 0.0;
+		double potential_energy = 0.0; // mutual gravity plus the work of the constant external forces
+		math::Vector3d linear_momentum = math::Vector3d(0.0);
+		math::Vector3d angular_momentum = math::Vector3d(0.0); // around the world origin
+
+		double momentum_scale = 0.0; // sum of every body's momentum magnitude, used to normalize the drift
+		double angular_momentum_scale = 0.0; // same as above, for the angular momentum
+
+		double GetTotalEnergy() const {return kinetic_energy + potential_energy;}
+
+		ConservedQuantities& operator+=(const ConservedQuantities& other)
+		{
+			kinetic_energy += other.kinetic_energy;
+			potential_energy += other.potential_energy;
+			linear_momentum += other.linear_momentum;
+			angular_momentum += other.angular_momentum;
+			momentum_scale += other.momentum_scale;
+			angular_momentum_scale += other.angular_momentum_scale;
+			return *this;
+		}
+	};
+
+	// computes the conserved quantities of the given bodies, splitting the O(N^2) potential energy across threads
+	// a thread count of zero uses every hardware thread
+	inline ConservedQuantities ComputeConservedQuantities(const std::span<const Body> bodies,
+		const float gravitational_constant, const Meter softening, u32 thread_count = 0)
+	{
+		// not worth spawning threads for a handful of bodies
+		constexpr usize MIN_BODIES_PER_THREAD = 256;
+
+		if (thread_count == 0)
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+		thread_count = static_cast<u32>(std::clamp<usize>(bodies.size() / MIN_BODIES_PER_THREAD, 1, thread_count));
+
+		const double softening_squared = static_cast<double>(softening) * softening;
+
+		// thread t handles bodies t, t + thread_count, ... which balances the triangular pair loop
+		auto accumulate = [&bodies, gravitational_constant, softening_squared, thread_count](const u32 first, ConservedQuantities& sum)
+		{
+			const usize body_count = bodies.size();
+			for (usize a = first; a < body_count; a += thread_count)
+			{
+				const Body& body = bodies[a];
+				const double mass = body.GetMass();
+				const math::Vector3d location(body.GetLocation());
+				const math::Vector3d velocity(body.GetVelocity());
+				const math::Vector3d momentum = mass * velocity;
+				const math::Vector3d angular_momentum = glm::cross(location, momentum);
+
+				sum.kinetic_energy += 0.5 * mass * glm::dot(velocity, velocity);
+				// a constant force F derives from the potential -F.x
+				sum.potential_energy -= glm::dot(math::Vector3d(body.GetForce()), location);
+				sum.linear_momentum += momentum;
+				sum.angular_momentum += angular_momentum;
+				sum.momentum_scale += glm::length(momentum);
+				sum.angular_momentum_scale += glm::length(angular_momentum);
+
+				if (gravitational_constant == 0.0f)
+					continue;
+
+				// Plummer-softened potential, consistent with Simulation::ComputeMutualGravity
+				double pair_potential = 0.0;
+				for (usize b = a + 1; b < body_count; b++)
+				{
+					const math::Vector3d a_to_b = math::Vector3d(bodies[b].GetLocation()) - location;
+					pair_potential += bodies[b].GetMass() / std::sqrt(glm::dot(a_to_b, a_to_b) + softening_squared);
+				}
+				sum.potential_energy -= gravitational_constant * mass * pair_potential;
+			}
+		};
+
+		std::vector<ConservedQuantities> partial_sums(thread_count);
+		std::vector<std::thread> workers;
+		workers.reserve(thread_count - 1);
+		for (u32 t = 1; t < thread_count; t++)
+			workers.emplace_back(accumulate, t, std::ref(partial_sums[t]));
+		accumulate(0, partial_sums[0]);
+		for (auto& worker : workers)
+			worker.join();
+
+		ConservedQuantities total;
+		for (const auto& partial_sum : partial_sums)
+			total += partial_sum;
+		return total;
+	}
+
+	// relative drift of the conserved quantities since the first sample, latest and worst values
+	struct DriftStatistics
+	{
+		u64 sample_count = 0;
+		ConservedQuantities initial, latest;
+
+		double energy_drift = 0.0, max_energy_drift = 0.0;
+		double momentum_drift = 0.0, max_momentum_drift = 0.0;
+		double angular_momentum_drift = 0.0, max_angular_momentum_drift = 0.0;
+	};
+
+	// samples a simulation every K ticks and tracks the drift of its conserved quantities
+	// momenta are only conserved by isolated systems: the linear momentum is corrected for the constant external
+	// forces, but static bodies or external forces make the angular momentum drift regardless of the integrator
+	class ConservationMonitor
+	{
+		u32 sample_interval; // in ticks
+		u32 thread_count;
+		DriftStatistics statistics;
+		timing::Seconds initial_time = 0.0f;
+		std::ofstream csv_file;
+
+		static double RelativeDrift(const double value, const double reference, const double scale)
+		{
+			const double denominator = std::abs(reference) > 0.0 ? std::abs(reference) : scale;
+			return denominator > 0.0 ? std::abs(value - reference) / denominator : 0.0;
+		}
+
+		static double RelativeDrift(const math::Vector3d& value, const math::Vector3d& reference, const double scale)
+		{
+			return scale > 0.0 ? glm::length(value - reference) / scale : 0.0;
+		}
+
+	public:
+		explicit ConservationMonitor(const u32 sample_interval = 1, const u32 thread_count = 0):
+			sample_interval(std::max(1u, sample_interval)), thread_count(thread_count)
+		{}
+
+		// writes every sample to a CSV file as well
+		void EnableCSVOutput(const std::string_view& file_path)
+		{
+			csv_file.open(file_path.data());
+			if (!csv_file.is_open())
+				throw std::runtime_error("Failed to open a CSV file for writing.");
+
+			csv_file << "tick,time,kinetic_energy,potential_energy,total_energy,energy_drift,"
+				"momentum_x,momentum_y,momentum_z,momentum_drift,"
+				"angular_momentum_x,angular_momentum_y,angular_momentum_z,angular_momentum_drift\n";
+		}
+
+		// the first sample becomes the reference every later one is compared to
+		void Reset()
+		{
+			statistics = DriftStatistics();
+		}
+
+		// call after every tick, the quantities are only computed every sample_interval ticks
+		void Sample(const Simulation& sim)
+		{
+			if (statistics.sample_count != 0 && sim.GetTickCount() % sample_interval != 0)
+				return;
+
+			const ConservedQuantities quantities = ComputeConservedQuantities(sim.GetBodies(),
+				sim.GetGravitationalConstant(), sim.GetSofteningLength(), thread_count);
+
+			if (statistics.sample_count == 0)
+			{
+				statistics.initial = quantities;
+				initial_time = sim.GetElapsedTime();
+			}
+			statistics.latest = quantities;
+			statistics.sample_count++;
+
+			const ConservedQuantities& initial = statistics.initial;
+
+			// constant external forces add their impulse to the momentum, which is expected
+			math::Vector3d external_force(0.0);
+			for (const auto& body : sim.GetBodies())
+				external_force += math::Vector3d(body.GetForce());
+			const math::Vector3d expected_momentum = initial.linear_momentum +
+				external_force * static_cast<double>(sim.GetElapsedTime() - initial_time);
+
+			statistics.energy_drift = RelativeDrift(quantities.GetTotalEnergy(), initial.GetTotalEnergy(),
+				initial.kinetic_energy + std::abs(initial.potential_energy));
+			statistics.momentum_drift = RelativeDrift(quantities.linear_momentum, expected_momentum,
+				initial.momentum_scale);
+			statistics.angular_momentum_drift = RelativeDrift(quantities.angular_momentum, initial.angular_momentum,
+				initial.angular_momentum_scale);
+
+			statistics.max_energy_drift = std::max(statistics.max_energy_drift, statistics.energy_drift);
+			statistics.max_momentum_drift = std::max(statistics.max_momentum_drift, statistics.momentum_drift);
+			statistics.max_angular_momentum_drift = std::max(statistics.max_angular_momentum_drift,
+				statistics.angular_momentum_drift);
+
+			if (csv_file.is_open())
+			{
+				csv_file << sim.GetTickCount() << ',' << sim.GetElapsedTime() << ','
+					<< quantities.kinetic_energy << ',' << quantities.potential_energy << ','
+					<< quantities.GetTotalEnergy() << ',' << statistics.energy_drift << ','
+					<< quantities.linear_momentum.x << ',' << quantities.linear_momentum.y << ','
+					<< quantities.linear_momentum.z << ',' << statistics.momentum_drift << ','
+					<< quantities.angular_momentum.x << ',' << quantities.angular_momentum.y << ','
+					<< quantities.angular_momentum.z << ',' << statistics.angular_momentum_drift << '\n';
+			}
+		}
+
+		const DriftStatistics& GetStatistics() const {return statistics;}
+	};
+}
@@ -0,0 +1,155 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_profiler.hh"
+#include "nge_timing.hh"
+#include "types.hh"
+
+// std headers
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <stop_token>
+#include <functional>
+#include <vector>
+#include <span>
+#include <exception>
+
+namespace nge
+{
+	// hands values from one writer thread to one reader thread without either ever waiting for the other
+	// the writer fills one buffer while the reader reads another, and the third holds the latest published value
+	// publishing twice before the reader acquires drops the older value, the reader only ever sees the latest one
+	template<typename T>
+	class TripleBuffer
+	{
+		// set on the shared index when it was published and not acquired yet
+		static constexpr u32 FRESH_BIT = 4;
+
+		std::array<T, 3> buffers;
+		u32 write_index = 0; // owned by the writer
+		u32 read_index = 1; // owned by the reader
+		alignas(64) std::atomic<u32> shared_index = 2;
+
+	public:
+		// buffer the writer fills, still holding whatever value it had 3 publications ago
+		T& GetWriteBuffer() {return buffers[write_index];}
+
+		// makes the write buffer the latest value, and takes the shared one to be written next
+		void Publish()
+		{
+			write_index = shared_index.exchange(write_index | FRESH_BIT, std::memory_order_acq_rel) & ~FRESH_BIT;
+		}
+
+		// takes the latest value if one was published since the last call, returns whether the read buffer changed
+		bool Acquire()
+		{
+			if ((shared_index.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+				return false;
+			read_index = shared_index.exchange(read_index, std::memory_order_acq_rel) & ~FRESH_BIT;
+			return true;
+		}
+
+		// buffer the reader reads, which stays untouched until the next Acquire
+		const T& GetReadBuffer() const {return buffers[read_index];}
+	};
+
+	// steps a simulation on its own thread, one step per frame or per batch of frames when it falls behind, producing
+	// immutable snapshots for the render thread
+	// the render thread draws the latest snapshot while the next one is being simulated, so a frame costs about the
+	// longest of both instead of their sum, for one frame of latency
+	template<typename Snapshot>
+	class SimulationThread
+	{
+	public:
+		// advances the simulation by the time of every given frame, one after the other, and writes its state into the
+		// snapshot, which holds an older state
+		// frames requested while the simulation is busy are all handed to the next step, which must simulate them
+		// separately rather than as one long frame, so that the result does not depend on how far behind it fell
+		using StepFunction = std::function<void(std::span<const timing::Seconds>, Snapshot&)>;
+
+	private:
+		StepFunction step;
+		TripleBuffer<Snapshot> snapshots;
+
+		std::mutex mutex;
+		std::condition_variable_any step_requested;
+		// times of the frames the simulation has not caught up with yet, all handed to the next step
+		std::vector<timing::Seconds> pending_times;
+		// error that stopped the simulation, rethrown on the render thread
+		std::exception_ptr error;
+
+		// last, so that the thread is joined before anything it uses is destroyed
+		std::jthread thread;
+
+		void Run(const std::stop_token stop_token)
+		{
+			NGE_PROFILE_THREAD("Simulation");
+			try
+			{
+				// swapped with the pending times, so that neither reallocates once they have grown to a few frames
+				std::vector<timing::Seconds> times;
+				while (true)
+				{
+					{
+						std::unique_lock lock(mutex);
+						if (!step_requested.wait(lock, stop_token, [this] {return !pending_times.empty();}))
+							return;
+						times.swap(pending_times);
+						pending_times.clear();
+					}
+					step(times, snapshots.GetWriteBuffer());
+					snapshots.Publish();
+				}
+			}
+			catch (...)
+			{
+				const std::lock_guard lock(mutex);
+				error = std::current_exception();
+			}
+		}
+
+	public:
+		explicit SimulationThread(StepFunction step):
+			step(std::move(step))
+		{}
+
+		SimulationThread(const SimulationThread&) = delete;
+		SimulationThread& operator=(const SimulationThread&) = delete;
+
+		// takes a first snapshot without advancing time, so that there is always one to draw, then starts the thread
+		void Start()
+		{
+			step({}, snapshots.GetWriteBuffer());
+			snapshots.Publish();
+			snapshots.Acquire();
+			thread = std::jthread([this](const std::stop_token stop_token) {Run(stop_token);});
+		}
+
+		// requests a frame of the given time, simulated while the caller draws the current snapshot
+		void Advance(const timing::Seconds time)
+		{
+			{
+				const std::lock_guard lock(mutex);
+				if (error)
+					std::rethrow_exception(error);
+				pending_times.push_back(time);
+			}
+			step_requested.notify_one();
+		}
+
+		// latest finished snapshot, valid until the next call
+		const Snapshot& GetLatest()
+		{
+			snapshots.Acquire();
+			return snapshots.GetReadBuffer();
+		}
+	};
+}
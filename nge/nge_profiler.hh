@@ -0,0 +1,357 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "build.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <array>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+
+namespace nge::profiling
+{
+	// a named span of time, in nanoseconds since the profiler was created
+	struct ProfileEvent
+	{
+		const char* name; // string literal, events only keep the pointer
+		u64 start;
+		u64 end;
+	};
+
+	// events of one thread (or of the GPU), appended by that thread only and read by the exporter without locking
+	class EventTrack
+	{
+	public:
+		// events past this count are dropped until the next capture
+		static constexpr u32 CAPACITY = 1 << 16;
+
+	private:
+		friend class Profiler;
+
+		std::string name;
+		const u32 id;
+		std::unique_ptr<ProfileEvent[]> events;
+		// published with release, so that the exporter sees every event below it
+		std::atomic<u32> count = 0;
+		std::atomic<u32> dropped_count = 0;
+		// capture the events belong to, the owner resets its track when it first records in a new capture
+		std::atomic<u32> generation = 0;
+
+	public:
+		EventTrack(const std::string_view name, const u32 id):
+			name(name), id(id), events(std::make_unique<ProfileEvent[]>(CAPACITY))
+		{}
+	};
+
+	// collects the events of every thread while capturing, and exports them for chrome://tracing or ui.perfetto.dev
+	// recording never locks nor allocates, only creating a track the first time a thread records does
+	// use the NGE_PROFILE_ macros rather than this class directly, so that profiling compiles out of shipping builds
+	class Profiler
+	{
+		const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+		std::atomic<bool> is_capturing = false;
+		std::atomic<u32> generation = 0;
+
+		// tracks are never destroyed, so that threads can keep a pointer to theirs
+		std::mutex tracks_mutex;
+		std::deque<EventTrack> tracks;
+
+	public:
+		static Profiler& Get()
+		{
+			static Profiler profiler;
+			return profiler;
+		}
+
+		// nanoseconds since the profiler was created
+		u64 Now() const
+		{
+			return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - epoch).count());
+		}
+
+		bool IsCapturing() const {return is_capturing.load(std::memory_order_relaxed);}
+
+		// discards the events of the previous capture and starts recording new ones
+		void StartCapture()
+		{
+			generation.fetch_add(1, std::memory_order_release);
+			is_capturing.store(true, std::memory_order_release);
+		}
+
+		// stops recording, events recorded until now can then be exported
+		void StopCapture()
+		{
+			is_capturing.store(false, std::memory_order_release);
+		}
+
+		// a new track, to be written by a single thread at a time
+		EventTrack& CreateTrack(const std::string_view name)
+		{
+			const std::lock_guard lock(tracks_mutex);
+			return tracks.emplace_back(name, static_cast<u32>(tracks.size()));
+		}
+
+		// track of the calling thread, created the first time it is needed
+		EventTrack& GetThreadTrack()
+		{
+			thread_local EventTrack* track = nullptr;
+			if (!track)
+				track = &CreateTrack("Thread");
+			return *track;
+		}
+
+		// names the calling thread's track in exported traces
+		void SetThreadName(const std::string_view name)
+		{
+			EventTrack& track = GetThreadTrack();
+			const std::lock_guard lock(tracks_mutex);
+			track.name = name;
+		}
+
+		// appends an event to a track, only from the thread writing to that track
+		void Record(EventTrack& track, const ProfileEvent& event)
+		{
+			if (!IsCapturing())
+				return;
+
+			const u32 current_generation = generation.load(std::memory_order_acquire);
+			if (track.generation.load(std::memory_order_relaxed) != current_generation)
+			{
+				track.count.store(0, std::memory_order_relaxed);
+				track.dropped_count.store(0, std::memory_order_relaxed);
+				track.generation.store(current_generation, std::memory_order_release);
+			}
+
+			const u32 count = track.count.load(std::memory_order_relaxed);
+			if (count == EventTrack::CAPACITY)
+			{
+				track.dropped_count.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			track.events[count] = event;
+			track.count.store(count + 1, std::memory_order_release);
+		}
+
+		// writes the events of the last capture as Chrome trace event JSON, best called once it is stopped
+		// returns the number of events written
+		usize ExportChromeTrace(const std::filesystem::path& path)
+		{
+			std::ofstream file(path);
+			if (!file)
+				throw std::runtime_error("Failed to open the trace file " + path.string() + '.');
+
+			auto write_string = [&file](const std::string_view string)
+			{
+				file << '"';
+				for (const char c : string)
+				{
+					if (c == '"' || c == '\\')
+						file << '\\';
+					file << c;
+				}
+				file << '"';
+			};
+
+			const u32 current_generation = generation.load(std::memory_order_acquire);
+			usize event_count = 0;
+			file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+			const std::lock_guard lock(tracks_mutex);
+			for (const auto& track : tracks)
+			{
+				if (track.id != 0)
+					file << ',';
+				file << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << track.id << ",\"args\":{\"name\":";
+				write_string(track.name);
+				file << "}}";
+
+				// tracks nothing was recorded in during this capture still hold the events of an older one
+				if (track.generation.load(std::memory_order_acquire) != current_generation)
+					continue;
+				const u32 count = track.count.load(std::memory_order_acquire);
+				for (u32 i = 0; i < count; i++)
+				{
+					const ProfileEvent& event = track.events[i];
+					// microseconds, with the nanoseconds as decimals
+					file << ",\n{\"ph\":\"X\",\"pid\":0,\"tid\":" << track.id << ",\"name\":";
+					write_string(event.name);
+					file << ",\"ts\":" << event.start / 1000 << '.' << std::to_string(1000 + event.start % 1000).substr(1)
+						<< ",\"dur\":" << (event.end - event.start) / 1000 << '.'
+						<< std::to_string(1000 + (event.end - event.start) % 1000).substr(1) << '}';
+				}
+				event_count += count;
+				if (const u32 dropped_count = track.dropped_count.load(std::memory_order_relaxed))
+				{
+					file << ",\n{\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":" << track.id
+						<< ",\"name\":\"dropped events\",\"ts\":0,\"args\":{\"count\":" << dropped_count << "}}";
+				}
+			}
+			file << "\n]}\n";
+
+			if (!file)
+				throw std::runtime_error("Failed to write the trace file " + path.string() + '.');
+			return event_count;
+		}
+	};
+
+	// records the time between its construction and destruction on the calling thread's track
+	class CpuScope
+	{
+		const char* name;
+		u64 start;
+
+	public:
+		explicit CpuScope(const char* name):
+			name(name), start(Profiler::Get().IsCapturing() ? Profiler::Get().Now() : 0)
+		{}
+
+		CpuScope(const CpuScope&) = delete;
+		CpuScope& operator=(const CpuScope&) = delete;
+
+		~CpuScope()
+		{
+			Profiler& profiler = Profiler::Get();
+			if (start != 0 && profiler.IsCapturing())
+				profiler.Record(profiler.GetThreadTrack(), {name, start, profiler.Now()});
+		}
+	};
+
+	// measures GPU time with GL_TIME_ELAPSED queries, on the thread owning the GL context
+	// queries are double-buffered: the results of a frame are read two frames later, when the GPU is done with it,
+	// and skipped rather than waited for if it is not, so that measuring never stalls the pipeline
+	// GL_TIME_ELAPSED queries cannot nest, a scope begun while another is running is not measured
+	// GPU events are placed on their own track at the time their commands were issued, only their duration is the GPU's
+	class GpuTimer
+	{
+	public:
+		static constexpr u32 MAX_SCOPES_PER_FRAME = 32;
+		static constexpr u32 FRAME_LATENCY = 2;
+
+	private:
+		struct Scope
+		{
+			const char* name;
+			u64 issue_time;
+		};
+
+		// generated with the first scope, since there is no context yet when the timer is created
+		std::array<std::array<GLuint, MAX_SCOPES_PER_FRAME>, FRAME_LATENCY> queries{};
+		std::array<std::array<Scope, MAX_SCOPES_PER_FRAME>, FRAME_LATENCY> scopes;
+		std::array<u32, FRAME_LATENCY> scope_counts{};
+		u32 frame = 0;
+		bool is_measuring = false;
+		EventTrack& track;
+
+		GpuTimer():
+			track(Profiler::Get().CreateTrack("GPU"))
+		{}
+
+	public:
+		// the timer of the current context
+		static GpuTimer& Current()
+		{
+			static GpuTimer timer;
+			return timer;
+		}
+
+		GpuTimer(const GpuTimer&) = delete;
+		GpuTimer& operator=(const GpuTimer&) = delete;
+
+		// collects the scopes measured FRAME_LATENCY frames ago and reuses their queries for the new frame
+		void BeginFrame()
+		{
+			frame = (frame + 1) % FRAME_LATENCY;
+			Profiler& profiler = Profiler::Get();
+			for (u32 i = 0; i < scope_counts[frame]; i++)
+			{
+				GLint is_available = GL_FALSE;
+				glGetQueryObjectiv(queries[frame][i], GL_QUERY_RESULT_AVAILABLE, &is_available);
+				if (!is_available)
+					continue;
+				GLuint64 elapsed = 0;
+				glGetQueryObjectui64v(queries[frame][i], GL_QUERY_RESULT, &elapsed);
+				profiler.Record(track, {scopes[frame][i].name, scopes[frame][i].issue_time, scopes[frame][i].issue_time + elapsed});
+			}
+			scope_counts[frame] = 0;
+		}
+
+		// starts measuring the following GL commands, returns whether it did, in which case End must be called
+		bool Begin(const char* name)
+		{
+			Profiler& profiler = Profiler::Get();
+			if (!profiler.IsCapturing() || is_measuring || scope_counts[frame] == MAX_SCOPES_PER_FRAME)
+				return false;
+			if (queries[frame][0] == 0)
+				glGenQueries(MAX_SCOPES_PER_FRAME, queries[frame].data());
+
+			const u32 scope = scope_counts[frame]++;
+			scopes[frame][scope] = {name, profiler.Now()};
+			glBeginQuery(GL_TIME_ELAPSED, queries[frame][scope]);
+			is_measuring = true;
+			return true;
+		}
+
+		void End()
+		{
+			glEndQuery(GL_TIME_ELAPSED);
+			is_measuring = false;
+		}
+	};
+
+	// measures the GL commands issued between its construction and destruction
+	class GpuScope
+	{
+		const bool is_measuring;
+
+	public:
+		explicit GpuScope(const char* name):
+			is_measuring(GpuTimer::Current().Begin(name))
+		{}
+
+		GpuScope(const GpuScope&) = delete;
+		GpuScope& operator=(const GpuScope&) = delete;
+
+		~GpuScope()
+		{
+			if (is_measuring)
+				GpuTimer::Current().End();
+		}
+	};
+}
+
+#define NGE_PROFILE_CONCATENATE_IMPLEMENTATION(a, b) a##b
+#define NGE_PROFILE_CONCATENATE(a, b) NGE_PROFILE_CONCATENATE_IMPLEMENTATION(a, b)
+
+#if SHIPPING_BUILD
+#define NGE_PROFILE_SCOPE(name)
+#define NGE_PROFILE_GPU_SCOPE(name)
+#define NGE_PROFILE_GPU_FRAME()
+#define NGE_PROFILE_THREAD(name)
+#else
+// measures the CPU time until the end of the enclosing scope, name must be a string literal
+#define NGE_PROFILE_SCOPE(name) const ::nge::profiling::CpuScope NGE_PROFILE_CONCATENATE(profile_scope_, __LINE__)(name)
+// measures the GPU time of the GL commands issued until the end of the enclosing scope
+#define NGE_PROFILE_GPU_SCOPE(name) const ::nge::profiling::GpuScope NGE_PROFILE_CONCATENATE(profile_gpu_scope_, __LINE__)(name)
+// once per frame on the thread owning the GL context, before any GPU scope
+#define NGE_PROFILE_GPU_FRAME() ::nge::profiling::GpuTimer::Current().BeginFrame()
+// names the calling thread's track in exported traces
+#define NGE_PROFILE_THREAD(name) ::nge::profiling::Profiler::Get().SetThreadName(name)
+#endif
@@ -0,0 +1,179 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace nge::graphics
+{
+	// linked programs saved on disk with glGetProgramBinary, so that later launches skip compiling and linking
+	// a program is found from a hash of its sources and of the driver vendor, renderer and version, since binaries only
+	// load on the driver that made them, and a binary the driver still rejects is simply compiled again and replaced
+	// failing to read or write the cache is never an error, it only costs a compile
+	class ProgramCache
+	{
+		// at the start of every file, followed by the binary format and the binary itself
+		static constexpr u32 MAGIC = 0x5047454E; // "NEGP"
+
+		std::filesystem::path directory;
+		std::string driver; // identifies the driver in the hash
+		bool is_supported;
+
+		// FNV-1a, only meant to tell programs apart
+		static u64 Hash(const std::string_view data, u64 hash = 0xCBF29CE484222325ull)
+		{
+			for (const char c : data)
+			{
+				hash ^= static_cast<u8>(c);
+				hash *= 0x100000001B3ull;
+			}
+			return hash;
+		}
+
+		std::filesystem::path GetPath(const u64 hash) const
+		{
+			constexpr char DIGITS[] = "0123456789abcdef";
+			std::string name(16, '0');
+			for (u32 i = 0; i < 16; i++)
+				name[15 - i] = DIGITS[(hash >> (i * 4)) & 0xF];
+			return directory / (name + ".bin");
+		}
+
+		static std::string GetCurrentDriver()
+		{
+			std::string driver;
+			for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+			{
+				const auto string = reinterpret_cast<const char*>(glGetString(name));
+				driver += string ? string : "";
+				driver += '\n';
+			}
+			return driver;
+		}
+
+	public:
+		// needs a current context, to identify its driver
+		explicit ProgramCache(std::filesystem::path directory):
+			ProgramCache(std::move(directory), GetCurrentDriver())
+		{
+		}
+
+		// identifies the driver by the given string instead, which only tests should need, to act as another driver
+		ProgramCache(std::filesystem::path directory, std::string driver):
+			directory(std::move(directory)), driver(std::move(driver)), is_supported(false)
+		{
+			// program binaries are core since GL 4.1, and a driver may support no format at all
+			GLint format_count = 0;
+			if (GLAD_GL_VERSION_4_1 && glProgramBinary)
+				glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+			is_supported = format_count > 0;
+		}
+
+		ProgramCache(const ProgramCache&) = delete;
+		ProgramCache& operator=(const ProgramCache&) = delete;
+
+		bool IsSupported() const {return is_supported;}
+
+		// identifies a program from the sources of its stages, in order
+		u64 ComputeKey(const std::span<const std::string_view> sources) const
+		{
+			u64 hash = Hash(driver);
+			for (const auto source : sources)
+				hash = Hash(std::string_view("\0", 1), Hash(source, hash)); // so that moving text across stages changes it
+			return hash;
+		}
+
+		// a linked program made from the cached binary, or 0 if there is none or the driver rejects it
+		GLuint Load(const u64 key) const
+		{
+			if (!is_supported)
+				return 0;
+
+			std::ifstream file(GetPath(key), std::ios::binary);
+			if (!file)
+				return 0;
+			u32 magic = 0;
+			GLenum format = 0;
+			file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+			file.read(reinterpret_cast<char*>(&format), sizeof(format));
+			// the rest is read from the stream buffer, which leaves the stream state alone, so only the header is checked
+			if (!file || magic != MAGIC)
+				return 0;
+			const std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			if (binary.empty())
+				return 0;
+
+			const GLuint program = glCreateProgram();
+			glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+			GLint success = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &success);
+			if (!success)
+			{
+				// usually a driver update that did not change the version string
+				glDeleteProgram(program);
+				return 0;
+			}
+			return program;
+		}
+
+		// to be called before linking a program meant to be stored
+		void PrepareLink(const GLuint program) const
+		{
+			if (is_supported)
+				glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+
+		// saves the binary of a linked program, replacing any older one
+		void Store(const u64 key, const GLuint program) const
+		{
+			if (!is_supported)
+				return;
+
+			GLint length = 0;
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length <= 0)
+				return;
+			std::vector<char> binary(static_cast<usize>(length));
+			GLenum format = 0;
+			glGetProgramBinary(program, length, &length, &format, binary.data());
+
+			// written aside and renamed, so that an interrupted write never leaves a truncated binary behind
+			std::error_code error;
+			std::filesystem::create_directories(directory, error);
+			const auto path = GetPath(key);
+			auto temporary_path = path;
+			temporary_path += ".tmp";
+			{
+				std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+				file.write(reinterpret_cast<const char*>(&MAGIC), sizeof(MAGIC));
+				file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+				file.write(binary.data(), length);
+				if (!file)
+				{
+					std::cerr << "Failed to write the program cache " << temporary_path.string() << '\n';
+					return;
+				}
+			}
+			std::filesystem::rename(temporary_path, path, error);
+			if (error)
+				std::cerr << "Failed to write the program cache " << path.string() << ": " << error.message() << '\n';
+		}
+	};
+}
@@ -0,0 +1,203 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_math.hh"
+#include "types.hh"
+
+// std headers
+#include <array>
+#include <span>
+#include <cmath>
+#include <numbers>
+#include <bit>
+#include <algorithm>
+
+namespace nge::random
+{
+	// only used to turn seeds into generator states, whose bits must not be correlated with the seed's
+	class SplitMix64
+	{
+		u64 state;
+
+	public:
+		explicit SplitMix64(const u64 seed):
+			state(seed)
+		{}
+
+		u64 Next()
+		{
+			u64 value = (state += 0x9E3779B97F4A7C15ull);
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+			return value ^ (value >> 31);
+		}
+	};
+
+	// xoshiro256++ from Blackman and Vigna, fast and of good quality over a period of 2^256 - 1
+	class Xoshiro256pp
+	{
+		std::array<u64, 4> state;
+
+	public:
+		// the state must not be all zeros
+		explicit Xoshiro256pp(const std::array<u64, 4>& state):
+			state(state)
+		{}
+
+		explicit Xoshiro256pp(const u64 seed, const u64 stream = 0):
+			state(MakeState(seed, stream))
+		{}
+
+		// stream s of a seed starts from the outputs 4s to 4s + 3 of a SplitMix64 seeded with it, so that streams of
+		// the same seed never share a state word and any number of them can be made independently
+		static std::array<u64, 4> MakeState(const u64 seed, const u64 stream)
+		{
+			SplitMix64 seeder(seed + stream * 4 * 0x9E3779B97F4A7C15ull);
+			std::array<u64, 4> state;
+			for (u64& word : state)
+				word = seeder.Next();
+			return state;
+		}
+
+		u64 Next()
+		{
+			const u64 value = std::rotl(state[0] + state[3], 23) + state[0];
+			const u64 t = state[1] << 17;
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= t;
+			state[3] = std::rotl(state[3], 45);
+			return value;
+		}
+	};
+
+	// uniform in [0, 1), from the 24 high bits which are the best ones and all a float can hold
+	inline float ToUnitFloat(const u64 value)
+	{
+		return static_cast<float>(static_cast<u32>(value >> 40)) * 0x1.0p-24f;
+	}
+
+	// random numbers for one user (an emitter, a thread...), which owns it and is the only one to use it
+	// it steps LANE_COUNT xoshiro256++ generators at once, one per SIMD lane: the state is laid out as structure of arrays
+	// and every lane does the same operations, so the compiler turns the loops over lanes into vector instructions
+	// the batch functions fill whole arrays at once, every step of the lanes giving LANE_COUNT consecutive values (or
+	// pairs for gaussians), so that a sequence only depends on the seed, the stream and the calls made
+	class Stream
+	{
+	public:
+		static constexpr u32 LANE_COUNT = 4;
+
+	private:
+		alignas(32) std::array<u64, LANE_COUNT> s0, s1, s2, s3;
+		// values drawn but not handed out yet by the single-value functions
+		alignas(32) std::array<u64, LANE_COUNT> pending;
+		u32 pending_index;
+
+	public:
+		// lane l is the xoshiro256++ stream stream * LANE_COUNT + l of the seed
+		explicit Stream(const u64 seed, const u64 stream = 0):
+			pending{}, pending_index(LANE_COUNT)
+		{
+			for (u32 lane = 0; lane < LANE_COUNT; lane++)
+			{
+				const auto state = Xoshiro256pp::MakeState(seed, stream * LANE_COUNT + lane);
+				s0[lane] = state[0];
+				s1[lane] = state[1];
+				s2[lane] = state[2];
+				s3[lane] = state[3];
+			}
+		}
+
+		// the next value of every lane
+		void NextLanes(std::array<u64, LANE_COUNT>& values)
+		{
+			for (u32 lane = 0; lane < LANE_COUNT; lane++)
+			{
+				values[lane] = std::rotl(s0[lane] + s3[lane], 23) + s0[lane];
+				const u64 t = s1[lane] << 17;
+				s2[lane] ^= s0[lane];
+				s3[lane] ^= s1[lane];
+				s1[lane] ^= s2[lane];
+				s0[lane] ^= s3[lane];
+				s2[lane] ^= t;
+				s3[lane] = std::rotl(s3[lane], 45);
+			}
+		}
+
+		u64 Next()
+		{
+			if (pending_index == LANE_COUNT)
+			{
+				NextLanes(pending);
+				pending_index = 0;
+			}
+			return pending[pending_index++];
+		}
+
+		// uniform in [min, max)
+		float NextUniform(const float min = 0.0f, const float max = 1.0f)
+		{
+			return min + ToUnitFloat(Next()) * (max - min);
+		}
+
+		// uniform in [min, max)
+		void FillUniform(const std::span<float> values, const float min = 0.0f, const float max = 1.0f)
+		{
+			const float range = max - min;
+			std::array<u64, LANE_COUNT> lanes;
+			for (usize i = 0; i < values.size(); i += LANE_COUNT)
+			{
+				NextLanes(lanes);
+				const usize count = std::min<usize>(LANE_COUNT, values.size() - i);
+				for (usize lane = 0; lane < count; lane++)
+					values[i + lane] = min + ToUnitFloat(lanes[lane]) * range;
+			}
+		}
+
+		// normally distributed, with the Box-Muller transform which turns every pair of uniforms into a pair of values
+		void FillGaussian(const std::span<float> values, const float mean = 0.0f, const float deviation = 1.0f)
+		{
+			std::array<u64, LANE_COUNT> radii, angles;
+			for (usize i = 0; i < values.size(); i += 2 * LANE_COUNT)
+			{
+				NextLanes(radii);
+				NextLanes(angles);
+				for (usize lane = 0; lane < LANE_COUNT && i + 2 * lane < values.size(); lane++)
+				{
+					// in (0, 1], so that the logarithm is finite
+					const float radius = std::sqrt(-2.0f * std::log(1.0f - ToUnitFloat(radii[lane]))) * deviation;
+					const float angle = ToUnitFloat(angles[lane]) * 2.0f * std::numbers::pi_v<float>;
+					values[i + 2 * lane] = mean + radius * std::cos(angle);
+					if (i + 2 * lane + 1 < values.size())
+						values[i + 2 * lane + 1] = mean + radius * std::sin(angle);
+				}
+			}
+		}
+
+		// uniformly distributed on the unit sphere, from a uniform height and a uniform angle around the vertical axis
+		void FillOnSphere(const std::span<vec3> directions)
+		{
+			std::array<u64, LANE_COUNT> heights, angles;
+			for (usize i = 0; i < directions.size(); i += LANE_COUNT)
+			{
+				NextLanes(heights);
+				NextLanes(angles);
+				const usize count = std::min<usize>(LANE_COUNT, directions.size() - i);
+				for (usize lane = 0; lane < count; lane++)
+				{
+					const float z = ToUnitFloat(heights[lane]) * 2.0f - 1.0f;
+					const float radius = std::sqrt(std::max(0.0f, 1.0f - z * z));
+					const float angle = ToUnitFloat(angles[lane]) * 2.0f * std::numbers::pi_v<float>;
+					directions[i + lane] = vec3(radius * std::cos(angle), radius * std::sin(angle), z);
+				}
+			}
+		}
+	};
+}
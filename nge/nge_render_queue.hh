@@ -0,0 +1,214 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_profiler.hh"
+#include "nge_state_cache.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <array>
+#include <vector>
+#include <span>
+#include <bit>
+#include <algorithm>
+
+namespace nge::graphics
+{
+	// passes of a frame, executed in this order whatever the submission order
+	enum class RenderLayer : u8
+	{
+		Opaque, // front to back, so that early depth testing rejects hidden fragments
+		Sky, // behind every opaque object, so only drawn where nothing else is
+		Overlay, // back to front, on top of everything else
+	};
+
+	// fixed-function state a draw needs, applied through the state cache
+	struct RenderState
+	{
+		bool depth_test = true;
+		GLenum depth_func = GL_LESS;
+		bool cull_face = true;
+		bool blend = false;
+		GLenum blend_source_factor = GL_ONE;
+		GLenum blend_destination_factor = GL_ZERO;
+	};
+
+	struct TextureBinding
+	{
+		u32 unit;
+		GLenum target;
+		GLuint texture;
+	};
+
+	// everything needed to issue one (instanced) draw call, recorded now and executed once the frame is sorted
+	struct DrawPacket
+	{
+		static constexpr u32 MAX_TEXTURES = 4;
+
+		u64 sort_key = 0;
+		GLuint program = 0;
+		RenderState state;
+		GLuint vertex_array = 0;
+		std::array<TextureBinding, MAX_TEXTURES> textures;
+		u32 texture_count = 0;
+
+		GLenum primitive = GL_TRIANGLES;
+		u32 vertex_count = 0;
+		bool is_indexed = false; // from the vertex array's element buffer
+		GLenum index_type = GL_UNSIGNED_SHORT;
+		u32 instance_count = 1;
+
+		// points the per-instance attributes of the bound vertex array at the instances, if the draw has any
+		// instances move every frame within the streaming buffer, so they are set for every draw
+		void (*set_instance_attributes)(GLuint buffer, usize offset) = nullptr;
+		GLuint instance_buffer = 0;
+		usize instance_offset = 0; // in bytes
+
+		void AddTexture(const u32 unit, const GLenum target, const GLuint texture)
+		{
+			textures[texture_count++] = {unit, target, texture};
+		}
+	};
+
+	// names of the layers in profiles
+	constexpr const char* RENDER_LAYER_NAMES[] = {"Opaque", "Sky", "Overlay"};
+
+	// collects the draws of a frame, sorts them by key and executes them with as few state changes as possible
+	// the 64-bit keys are, from the most significant bits:
+	// - opaque and sky: layer (8 bits), program (12 bits), material (12 bits), depth (32 bits) growing away from the camera
+	// - overlay: layer (8 bits), depth (32 bits) growing towards the camera, program (12 bits), material (12 bits)
+	// draws with equal keys keep their submission order, so that a frame is always drawn the same way
+	class RenderQueue
+	{
+		std::vector<DrawPacket> packets;
+		// sort keys paired with their packet index, and the scratch space of the radix sort
+		std::vector<u64> keys, sorted_keys;
+		std::vector<u32> order, sorted_order;
+
+		static u64 QuantizeDepth(const float depth)
+		{
+			// non-negative floats compare like their bit patterns
+			return std::bit_cast<u32>(std::max(depth, 0.0f));
+		}
+
+		// LSD radix sort on bytes, stable and skipping the bytes every key shares
+		void SortKeys()
+		{
+			const usize count = keys.size();
+			sorted_keys.resize(count);
+			sorted_order.resize(count);
+
+			for (u32 shift = 0; shift < 64; shift += 8)
+			{
+				std::array<usize, 256> offsets{};
+				for (const u64 key : keys)
+					offsets[(key >> shift) & 0xFF]++;
+				if (std::any_of(offsets.begin(), offsets.end(), [count](const usize bucket_size) {return bucket_size == count;}))
+					continue;
+
+				usize offset = 0;
+				for (auto& bucket : offsets)
+				{
+					const usize bucket_size = bucket;
+					bucket = offset;
+					offset += bucket_size;
+				}
+				for (usize i = 0; i < count; i++)
+				{
+					const usize destination = offsets[(keys[i] >> shift) & 0xFF]++;
+					sorted_keys[destination] = keys[i];
+					sorted_order[destination] = order[i];
+				}
+				keys.swap(sorted_keys);
+				order.swap(sorted_order);
+			}
+		}
+
+	public:
+		// key of a draw sorted to minimize state changes first, then front to back
+		static u64 MakeSortKey(const RenderLayer layer, const GLuint program, const u32 material, const float depth)
+		{
+			const u64 layer_bits = static_cast<u64>(layer) << 56;
+			const u64 state_bits = (static_cast<u64>(program & 0xFFF) << 12) | (material & 0xFFF);
+			if (layer == RenderLayer::Overlay)
+				return layer_bits | ((0xFFFFFFFFull - QuantizeDepth(depth)) << 24) | state_bits;
+			return layer_bits | (state_bits << 32) | QuantizeDepth(depth);
+		}
+
+		void Clear()
+		{
+			packets.clear();
+		}
+
+		void Submit(const DrawPacket& packet)
+		{
+			packets.push_back(packet);
+		}
+
+		usize GetPacketCount() const {return packets.size();}
+
+		// sorts the packets submitted since the last Clear, giving their indices in the order they are drawn
+		std::span<const u32> Sort()
+		{
+			keys.resize(packets.size());
+			order.resize(packets.size());
+			for (usize i = 0; i < packets.size(); i++)
+			{
+				keys[i] = packets[i].sort_key;
+				order[i] = static_cast<u32>(i);
+			}
+			SortKeys();
+			return order;
+		}
+
+		// sorts and draws every packet submitted since the last Clear
+		void Execute()
+		{
+			NGE_PROFILE_SCOPE("RenderQueue::Execute");
+			Sort();
+
+			StateCache& state = StateCache::Current();
+			// the layers are consecutive once sorted, each is profiled on its own
+			for (usize first = 0; first < order.size();)
+			{
+				const u64 layer = keys[first] >> 56;
+				usize last = first;
+				while (last < order.size() && keys[last] >> 56 == layer)
+					last++;
+				NGE_PROFILE_SCOPE(RENDER_LAYER_NAMES[layer]);
+				NGE_PROFILE_GPU_SCOPE(RENDER_LAYER_NAMES[layer]);
+
+				for (usize i = first; i < last; i++)
+				{
+					const DrawPacket& packet = packets[order[i]];
+					state.UseProgram(packet.program);
+					state.SetDepthTest(packet.state.depth_test);
+					state.SetDepthFunc(packet.state.depth_func);
+					state.SetCullFace(packet.state.cull_face);
+					state.SetBlend(packet.state.blend);
+					state.SetBlendFunc(packet.state.blend_source_factor, packet.state.blend_destination_factor);
+					for (u32 t = 0; t < packet.texture_count; t++)
+						state.BindTexture(packet.textures[t].unit, packet.textures[t].target, packet.textures[t].texture);
+					state.BindVertexArray(packet.vertex_array);
+					if (packet.set_instance_attributes)
+						packet.set_instance_attributes(packet.instance_buffer, packet.instance_offset);
+
+					if (packet.is_indexed)
+						glDrawElementsInstanced(packet.primitive, (GLsizei)packet.vertex_count, packet.index_type, nullptr, (GLsizei)packet.instance_count);
+					else
+						glDrawArraysInstanced(packet.primitive, 0, (GLsizei)packet.vertex_count, (GLsizei)packet.instance_count);
+				}
+				first = last;
+			}
+			state.BindVertexArray(0);
+		}
+	};
+}
@@ -0,0 +1,281 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_math.hh"
+#include "nge_program_cache.hh"
+#include "nge_state_cache.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <string>
+#include <string_view>
+#include <span>
+#include <vector>
+#include <initializer_list>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace nge::graphics
+{
+	// per-frame data shared by every program through a uniform buffer, in std140 layout
+	// every program declaring a "FrameUniforms" block gets it bound automatically
+	struct FrameUniforms
+	{
+		mat4 view_projection_matrix;
+		vec4 view_position; // w is unused
+		vec4 light_position; // w is unused
+		vec4 light_diffuse; // w is unused
+		vec4 light_specular; // w is unused
+		vec4 light_cluster_parameters; // near plane distance and slices per unit of log depth of LightClusters, zw are unused
+	};
+
+	// uniform buffer binding points, one per uniform block name
+	static constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+
+	// handle to a uniform, looked up once when a program is loaded and reused every frame
+	// setting an invalid handle (an inactive or missing uniform) is silently ignored by GL
+	struct Uniform
+	{
+		GLint location = -1;
+
+		bool IsValid() const {return location >= 0;}
+	};
+
+	class Shader
+	{
+		GLuint program;
+		std::unordered_map<std::string, GLint> uniform_locations; // every active uniform, reflected at link time
+
+		static GLuint CompileStage(const GLenum stage, const std::string& source, const std::string_view& file_path)
+		{
+			const GLuint shader = glCreateShader(stage);
+			const char* source_data = source.c_str();
+			glShaderSource(shader, 1, &source_data, nullptr);
+			glCompileShader(shader);
+
+			GLint success;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+			if (!success)
+			{
+				GLchar info_log[1024];
+				glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+				glDeleteShader(shader);
+				throw std::runtime_error("Failed to compile " + std::string(file_path) + ": " + info_log);
+			}
+			return shader;
+		}
+
+		// records the location of every active uniform, and binds the known uniform blocks
+		void Reflect()
+		{
+			GLint uniform_count = 0;
+			glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniform_count);
+			for (GLint i = 0; i < uniform_count; i++)
+			{
+				GLchar name[256];
+				GLsizei name_length;
+				GLint size;
+				GLenum type;
+				glGetActiveUniform(program, (GLuint)i, sizeof(name), &name_length, &size, &type, name);
+
+				// uniforms inside of blocks have no location
+				const GLint location = glGetUniformLocation(program, name);
+				if (location < 0)
+					continue;
+
+				// arrays are reported as "name[0]", but are usually addressed by their bare name
+				std::string uniform_name(name, name_length);
+				if (uniform_name.ends_with("[0]"))
+					uniform_locations.emplace(uniform_name.substr(0, uniform_name.size() - 3), location);
+				uniform_locations.emplace(std::move(uniform_name), location);
+			}
+
+			const GLuint frame_uniforms_index = glGetUniformBlockIndex(program, "FrameUniforms");
+			if (frame_uniforms_index != GL_INVALID_INDEX)
+				glUniformBlockBinding(program, frame_uniforms_index, FRAME_UNIFORMS_BINDING);
+		}
+
+		// a stage to compile, with the file it was read from for errors
+		struct StageSource
+		{
+			GLenum stage;
+			const std::string& source;
+			std::string_view path;
+		};
+
+		// the varyings are captured by transform feedback, interleaved in one buffer in this order, if there are any
+		static GLuint CompileAndLink(const std::initializer_list<StageSource> stages,
+			const std::span<const char* const> feedback_varyings, const ProgramCache* cache)
+		{
+			std::vector<GLuint> shaders;
+			std::string paths;
+			try
+			{
+				for (const StageSource& stage : stages)
+				{
+					shaders.push_back(CompileStage(stage.stage, stage.source, stage.path));
+					paths += (paths.empty() ? "" : " and ") + std::string(stage.path);
+				}
+			}
+			catch (...)
+			{
+				for (const GLuint shader : shaders)
+					glDeleteShader(shader);
+				throw;
+			}
+
+			const GLuint program = glCreateProgram();
+			if (cache)
+				cache->PrepareLink(program);
+			for (const GLuint shader : shaders)
+				glAttachShader(program, shader);
+			if (!feedback_varyings.empty())
+				glTransformFeedbackVaryings(program, (GLsizei)feedback_varyings.size(), feedback_varyings.data(), GL_INTERLEAVED_ATTRIBS);
+			glLinkProgram(program);
+			// the shaders are linked into our program now and no longer necessary
+			for (const GLuint shader : shaders)
+				glDeleteShader(shader);
+
+			GLint success;
+			glGetProgramiv(program, GL_LINK_STATUS, &success);
+			if (!success)
+			{
+				GLchar info_log[1024];
+				glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+				glDeleteProgram(program);
+				throw std::runtime_error("Failed to link " + paths + ": " + info_log);
+			}
+			return program;
+		}
+
+		// the program is loaded from the cache if given and it has it, and compiled and stored into it otherwise
+		void Load(const std::initializer_list<StageSource> stages, const std::span<const char* const> feedback_varyings,
+			const ProgramCache* cache)
+		{
+			u64 cache_key = 0;
+			if (cache)
+			{
+				std::vector<std::string_view> sources;
+				for (const StageSource& stage : stages)
+					sources.push_back(stage.source);
+				// the varyings change the binary as much as the sources do
+				std::string varyings;
+				for (const char* varying : feedback_varyings)
+					varyings += std::string(varying) + '\n';
+				if (!varyings.empty())
+					sources.push_back(varyings);
+				cache_key = cache->ComputeKey(sources);
+				program = cache->Load(cache_key);
+			}
+			if (!program)
+			{
+				program = CompileAndLink(stages, feedback_varyings, cache);
+				if (cache)
+					cache->Store(cache_key, program);
+			}
+
+			Reflect();
+		}
+
+	public:
+		static std::string ReadSourceFile(const std::string_view& file_path)
+		{
+			std::ifstream source_file(file_path.data());
+			if (!source_file.is_open())
+				throw std::runtime_error("Failed to open a shader file for reading: " + std::string(file_path));
+
+			std::stringstream source;
+			source << source_file.rdbuf();
+			return source.str();
+		}
+
+		// places the header after the #version line, which must come first, followed by a #line directive so that errors
+		// keep the line numbers of the source
+		static std::string InsertHeader(const std::string& source, const std::string_view& header)
+		{
+			if (header.empty())
+				return source;
+
+			const usize version = source.find("#version");
+			if (version != std::string::npos && version != 0)
+				throw std::runtime_error("Shaders given a header must start with their #version line.");
+			usize version_end = 0;
+			if (version == 0)
+			{
+				version_end = source.find('\n');
+				version_end = version_end == std::string::npos ? source.size() : version_end + 1;
+			}
+
+			std::string result = source.substr(0, version_end);
+			if (!result.empty() && result.back() != '\n')
+				result += '\n';
+			return result + std::string(header) + "\n#line " + (version_end ? "2" : "1") + '\n' + source.substr(version_end);
+		}
+
+		Shader(const std::string_view& vertex_path, const std::string_view& fragment_path, const ProgramCache* cache = nullptr):
+			Shader(vertex_path, fragment_path, {}, cache)
+		{
+		}
+
+		// the fragment header is GLSL shared by several programs, placed after the #version line of the fragment shader
+		Shader(const std::string_view& vertex_path, const std::string_view& fragment_path,
+			const std::string_view& fragment_header, const ProgramCache* cache = nullptr):
+			program(0)
+		{
+			const std::string vertex_source = ReadSourceFile(vertex_path);
+			const std::string fragment_source = InsertHeader(ReadSourceFile(fragment_path), fragment_header);
+			Load({{GL_VERTEX_SHADER, vertex_source, vertex_path}, {GL_FRAGMENT_SHADER, fragment_source, fragment_path}}, {},
+				cache);
+		}
+
+		// program without rasterization, whose vertex shader outputs are captured by transform feedback
+		Shader(const std::string_view& vertex_path, const std::span<const char* const> feedback_varyings,
+			const ProgramCache* cache = nullptr):
+			program(0)
+		{
+			const std::string vertex_source = ReadSourceFile(vertex_path);
+			Load({{GL_VERTEX_SHADER, vertex_source, vertex_path}}, feedback_varyings, cache);
+		}
+
+		Shader(const Shader&) = delete;
+		Shader& operator=(const Shader&) = delete;
+
+		~Shader()
+		{
+			glDeleteProgram(program);
+			StateCache::Current().OnProgramDeleted(program);
+		}
+
+		void Use() const
+		{
+			StateCache::Current().UseProgram(program);
+		}
+
+		// looks up a uniform by name, meant to be done once rather than every frame
+		Uniform GetUniform(const std::string_view& name) const
+		{
+			const auto found = uniform_locations.find(std::string(name));
+			return {found != uniform_locations.end() ? found->second : -1};
+		}
+
+		// the setters apply to the program currently in use
+		void SetUniform(const Uniform uniform, const s32 value) const {glUniform1i(uniform.location, value);}
+		void SetUniform(const Uniform uniform, const u32 value) const {glUniform1ui(uniform.location, value);}
+		void SetUniform(const Uniform uniform, const float value) const {glUniform1f(uniform.location, value);}
+		void SetUniform(const Uniform uniform, const vec3& value) const {glUniform3fv(uniform.location, 1, &value[0]);}
+		void SetUniform(const Uniform uniform, const vec4& value) const {glUniform4fv(uniform.location, 1, &value[0]);}
+		void SetUniform(const Uniform uniform, const mat4& value) const {glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &value[0][0]);}
+
+		GLuint GetHandle() const {return program;}
+	};
+}
@@ -0,0 +1,212 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace nge::graphics
+{
+	// shadows the GL state and skips every call that would not change anything
+	// all state changes of the kinds it tracks must go through it, otherwise call Invalidate()
+	class StateCache
+	{
+	public:
+		static constexpr u32 MAX_TEXTURE_UNITS = 16;
+
+		struct Statistics
+		{
+			u64 issued_calls = 0;
+			u64 filtered_calls = 0; // redundant calls which never reached GL
+		};
+
+	private:
+		static constexpr GLuint UNKNOWN_OBJECT = ~GLuint(0);
+		static constexpr GLenum UNKNOWN_ENUM = ~GLenum(0);
+
+		// texture targets tracked per unit, a unit can have one texture bound for each of them
+		static constexpr std::array<GLenum, 4> TEXTURE_TARGETS = {GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP,
+			GL_TEXTURE_BUFFER};
+
+		// capabilities are unknown until first set
+		enum class Toggle : s8
+		{
+			Unknown = -1,
+			Disabled = 0,
+			Enabled = 1,
+		};
+
+		GLuint program;
+		GLuint vertex_array;
+		u32 active_texture_unit;
+		std::array<std::array<GLuint, TEXTURE_TARGETS.size()>, MAX_TEXTURE_UNITS> bound_textures;
+		Toggle depth_test, cull_face, blend;
+		GLenum depth_func;
+		GLenum blend_source_factor, blend_destination_factor;
+
+		Statistics statistics;
+
+		// returns whether the call needs to be issued, and counts it
+		bool Changes(const bool changes)
+		{
+			if (changes)
+				statistics.issued_calls++;
+			else
+				statistics.filtered_calls++;
+			return changes;
+		}
+
+		void SetCapability(Toggle& current, const GLenum capability, const bool enabled)
+		{
+			const Toggle requested = enabled ? Toggle::Enabled : Toggle::Disabled;
+			if (!Changes(current != requested))
+				return;
+
+			current = requested;
+			if (enabled)
+				glEnable(capability);
+			else
+				glDisable(capability);
+		}
+
+		static usize GetTargetIndex(const GLenum target)
+		{
+			for (usize i = 0; i < TEXTURE_TARGETS.size(); i++)
+			{
+				if (TEXTURE_TARGETS[i] == target)
+					return i;
+			}
+			// sharing another target's slot would make the cache skip binds it must issue
+			throw std::runtime_error("Texture target not tracked by the state cache.");
+		}
+
+	public:
+		StateCache()
+		{
+			Invalidate();
+		}
+
+		// the engine renders with a single GL context, and so with a single cache
+		static StateCache& Current()
+		{
+			static StateCache cache;
+			return cache;
+		}
+
+		// forgets everything, so that the next calls are all issued (after any GL call bypassing the cache)
+		void Invalidate()
+		{
+			program = UNKNOWN_OBJECT;
+			vertex_array = UNKNOWN_OBJECT;
+			active_texture_unit = UNKNOWN_OBJECT;
+			for (auto& unit : bound_textures)
+				unit.fill(UNKNOWN_OBJECT);
+			depth_test = cull_face = blend = Toggle::Unknown;
+			depth_func = UNKNOWN_ENUM;
+			blend_source_factor = blend_destination_factor = UNKNOWN_ENUM;
+		}
+
+		void UseProgram(const GLuint new_program)
+		{
+			if (!Changes(program != new_program))
+				return;
+
+			program = new_program;
+			glUseProgram(new_program);
+		}
+
+		void BindVertexArray(const GLuint new_vertex_array)
+		{
+			if (!Changes(vertex_array != new_vertex_array))
+				return;
+
+			vertex_array = new_vertex_array;
+			glBindVertexArray(new_vertex_array);
+		}
+
+		void BindTexture(const u32 unit, const GLenum target, const GLuint texture)
+		{
+			assert(unit < MAX_TEXTURE_UNITS);
+			GLuint& bound_texture = bound_textures[unit][GetTargetIndex(target)];
+			if (!Changes(bound_texture != texture))
+				return;
+
+			SetActiveTexture(unit);
+			bound_texture = texture;
+			glBindTexture(target, texture);
+		}
+
+		// the unit that calls on a bound texture bypassing the cache (setting its storage) apply to
+		void SetActiveTexture(const u32 unit)
+		{
+			assert(unit < MAX_TEXTURE_UNITS);
+			if (!Changes(active_texture_unit != unit))
+				return;
+
+			active_texture_unit = unit;
+			glActiveTexture(GL_TEXTURE0 + unit);
+		}
+
+		void SetDepthTest(const bool enabled) {SetCapability(depth_test, GL_DEPTH_TEST, enabled);}
+		void SetCullFace(const bool enabled) {SetCapability(cull_face, GL_CULL_FACE, enabled);}
+		void SetBlend(const bool enabled) {SetCapability(blend, GL_BLEND, enabled);}
+
+		void SetDepthFunc(const GLenum func)
+		{
+			if (!Changes(depth_func != func))
+				return;
+
+			depth_func = func;
+			glDepthFunc(func);
+		}
+
+		void SetBlendFunc(const GLenum source_factor, const GLenum destination_factor)
+		{
+			if (!Changes(blend_source_factor != source_factor || blend_destination_factor != destination_factor))
+				return;
+
+			blend_source_factor = source_factor;
+			blend_destination_factor = destination_factor;
+			glBlendFunc(source_factor, destination_factor);
+		}
+
+		// deleted objects may have their names reused, so they must not be considered bound anymore
+		void OnProgramDeleted(const GLuint deleted_program)
+		{
+			if (program == deleted_program)
+				program = UNKNOWN_OBJECT;
+		}
+
+		void OnVertexArrayDeleted(const GLuint deleted_vertex_array)
+		{
+			if (vertex_array == deleted_vertex_array)
+				vertex_array = UNKNOWN_OBJECT;
+		}
+
+		void OnTextureDeleted(const GLuint deleted_texture)
+		{
+			for (auto& unit : bound_textures)
+			{
+				for (auto& bound_texture : unit)
+				{
+					if (bound_texture == deleted_texture)
+						bound_texture = UNKNOWN_OBJECT;
+				}
+			}
+		}
+
+		const Statistics& GetStatistics() const {return statistics;}
+		void ResetStatistics() {statistics = Statistics();}
+	};
+}
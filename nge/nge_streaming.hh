@@ -0,0 +1,207 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <array>
+#include <vector>
+#include <span>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+
+namespace nge::graphics
+{
+	// part of a streaming buffer written by the CPU this frame, and read by the GPU from the buffer at the offset
+	struct StreamAllocation
+	{
+		void* data;
+		GLuint buffer;
+		usize offset; // in bytes
+		usize size; // in bytes
+	};
+
+	// ring buffer for everything rewritten every frame: instances, particles and uniform blocks
+	// when buffer storage is available (GL 4.4, which made ARB_buffer_storage core), the buffer is mapped once, persistently and
+	// coherently, and split into one region per frame in flight: the CPU writes straight into the region of the current
+	// frame while the GPU reads the previous ones, and a fence per region keeps the CPU from writing into a region the
+	// GPU still reads, which only ever waits if the GPU is more than FRAME_COUNT - 1 frames behind
+	// otherwise, the frame is written into memory and uploaded by Flush into storage orphaned at the start of every frame
+	// the buffer is used on the thread owning the context only
+	class StreamingBuffer
+	{
+	public:
+		static constexpr u32 FRAME_COUNT = 3;
+
+	private:
+		GLuint buffer;
+		usize frame_capacity; // in bytes
+		usize uniform_alignment;
+		bool is_persistent;
+
+		// persistent path, with the region of the current frame
+		u8* mapping;
+		u32 region;
+		std::array<GLsync, FRAME_COUNT> fences{};
+
+		// orphaning path
+		std::vector<u8> staging;
+
+		usize frame_size; // bytes allocated this frame
+
+		u8* GetRegionData()
+		{
+			return is_persistent ? mapping + region * frame_capacity : staging.data();
+		}
+
+		usize GetRegionOffset() const
+		{
+			return is_persistent ? region * frame_capacity : 0;
+		}
+
+	public:
+		// capacity is the most bytes a single frame allocates
+		// allow_persistent can turn the persistent path off, to orphan on drivers which have buffer storage as well
+		explicit StreamingBuffer(const usize capacity, const bool allow_persistent = true):
+			buffer(0), frame_capacity(0), uniform_alignment(0), is_persistent(false), mapping(nullptr),
+			region(0), frame_size(0)
+		{
+			GLint alignment = 0;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			uniform_alignment = std::max<usize>(alignment, 16);
+			// so that every region starts aligned for uniform blocks
+			frame_capacity = (capacity + uniform_alignment - 1) / uniform_alignment * uniform_alignment;
+
+			glGenBuffers(1, &buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			// the loader only knows the core function, so the extension alone on an older context is not enough
+			if (allow_persistent && GLAD_GL_VERSION_4_4 && glBufferStorage)
+			{
+				constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr)(frame_capacity * FRAME_COUNT), nullptr, flags);
+				mapping = static_cast<u8*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(frame_capacity * FRAME_COUNT), flags));
+				if (!mapping)
+					throw std::runtime_error("Failed to map the streaming buffer.");
+				is_persistent = true;
+			}
+			else
+			{
+				glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)frame_capacity, nullptr, GL_STREAM_DRAW);
+				staging.resize(frame_capacity);
+			}
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		StreamingBuffer(const StreamingBuffer&) = delete;
+		StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+		~StreamingBuffer()
+		{
+			for (const GLsync fence : fences)
+			{
+				if (fence)
+					glDeleteSync(fence);
+			}
+			if (is_persistent)
+			{
+				glBindBuffer(GL_ARRAY_BUFFER, buffer);
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+			glDeleteBuffers(1, &buffer);
+		}
+
+		// moves on to the region of the next frame, waiting for the GPU to be done reading it if needed
+		void BeginFrame()
+		{
+			frame_size = 0;
+			if (!is_persistent)
+			{
+				// the previous storage lives on until the GPU is done with it, so this never waits
+				glBindBuffer(GL_ARRAY_BUFFER, buffer);
+				glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)frame_capacity, nullptr, GL_STREAM_DRAW);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+				return;
+			}
+
+			region = (region + 1) % FRAME_COUNT;
+			if (GLsync& fence = fences[region])
+			{
+				constexpr GLuint64 TIMEOUT = 1'000'000'000; // in nanoseconds
+				GLenum status;
+				while ((status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT)) == GL_TIMEOUT_EXPIRED)
+					;
+				if (status == GL_WAIT_FAILED)
+					throw std::runtime_error("Failed to wait for the GPU to release a streaming buffer region.");
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+
+		// reserves bytes of the current frame, offset being a multiple of the alignment (a power of two)
+		StreamAllocation Allocate(const usize size, const usize alignment = 16)
+		{
+			// aligned in the buffer rather than in the region, whose start is only aligned for uniform blocks
+			const usize region_offset = GetRegionOffset();
+			const usize start = ((region_offset + frame_size + alignment - 1) & ~(alignment - 1)) - region_offset;
+			if (start + size > frame_capacity)
+			{
+				throw std::runtime_error("The frame needs more than the " + std::to_string(frame_capacity) +
+					" bytes of its streaming buffer.");
+			}
+			frame_size = start + size;
+			return {GetRegionData() + start, buffer, GetRegionOffset() + start, size};
+		}
+
+		// copies the values into the current frame
+		template<typename T>
+		StreamAllocation Write(const std::span<const T> values, const usize alignment = 16)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			const StreamAllocation allocation = Allocate(values.size_bytes(), alignment);
+			if (!values.empty())
+				std::memcpy(allocation.data, values.data(), values.size_bytes());
+			return allocation;
+		}
+
+		// copies a std140 block into the current frame and binds it to a uniform buffer binding point
+		template<typename T>
+		void WriteUniforms(const GLuint binding, const T& uniforms)
+		{
+			const StreamAllocation allocation = Write(std::span<const T>(&uniforms, 1), uniform_alignment);
+			glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, (GLintptr)allocation.offset, (GLsizeiptr)allocation.size);
+		}
+
+		// makes this frame's writes visible to the GPU, to be called after the last allocation and before the first draw
+		void Flush()
+		{
+			if (is_persistent || frame_size == 0)
+				return; // coherent mappings need no flush
+
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)frame_size, staging.data());
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		// marks the end of the GPU commands reading this frame's region, to be called after its last draw
+		void EndFrame()
+		{
+			if (is_persistent)
+				fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		bool IsPersistent() const {return is_persistent;}
+		GLuint GetHandle() const {return buffer;}
+	};
+}
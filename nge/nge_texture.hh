@@ -0,0 +1,188 @@
+//==============================================================================
+//	NGE - Neutron Game Engine
+//	(C) 2024 Moczulski Alan
+//==============================================================================
+
+#pragma once
+
+// engine headers
+#include "nge_state_cache.hh"
+#include "types.hh"
+
+// GL headers
+#include <glad/glad.h>
+
+// std headers
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+namespace nge::graphics
+{
+	// 8-bit RGB pixels, tightly packed rows in the order they are uploaded
+	struct Image
+	{
+		static constexpr u32 CHANNELS = 3;
+
+		u32 width = 0;
+		u32 height = 0;
+		std::vector<u8> pixels;
+
+		bool IsEmpty() const {return pixels.empty();}
+	};
+
+	// contribution of one source texel to a resampled texel
+	struct ResampleTap
+	{
+		u32 source;
+		float weight;
+	};
+
+	// tent filter taps of every destination texel along one axis
+	// when minifying the filter widens to the scale, so that every source texel contributes
+	inline std::vector<std::vector<ResampleTap>> ComputeResampleTaps(const u32 source_size, const u32 destination_size)
+	{
+		const float scale = static_cast<float>(source_size) / static_cast<float>(destination_size);
+		const float radius = std::max(1.0f, scale);
+
+		std::vector<std::vector<ResampleTap>> taps(destination_size);
+		for (u32 destination = 0; destination < destination_size; destination++)
+		{
+			const float center = (static_cast<float>(destination) + 0.5f) * scale - 0.5f;
+			const s64 first = static_cast<s64>(std::floor(center - radius)) + 1;
+			const s64 last = static_cast<s64>(std::floor(center + radius));
+
+			float weight_sum = 0.0f;
+			for (s64 source = first; source <= last; source++)
+			{
+				const float weight = 1.0f - std::abs(static_cast<float>(source) - center) / radius;
+				if (weight <= 0.0f)
+					continue;
+
+				taps[destination].push_back({static_cast<u32>(std::clamp<s64>(source, 0, source_size - 1)), weight});
+				weight_sum += weight;
+			}
+			for (auto& tap : taps[destination])
+				tap.weight /= weight_sum;
+		}
+		return taps;
+	}
+
+	// resamples an image to the given size, one axis after the other
+	inline Image ResampleImage(const Image& source, const u32 width, const u32 height)
+	{
+		if (source.width == width && source.height == height)
+			return source;
+
+		constexpr u32 CHANNELS = Image::CHANNELS;
+		const auto horizontal_taps = ComputeResampleTaps(source.width, width);
+		const auto vertical_taps = ComputeResampleTaps(source.height, height);
+
+		// horizontal pass, kept in floating point so that the vertical one does not round twice
+		std::vector<float> rows(static_cast<usize>(width) * source.height * CHANNELS);
+		for (u32 y = 0; y < source.height; y++)
+		{
+			const u8* source_row = &source.pixels[static_cast<usize>(y) * source.width * CHANNELS];
+			float* row = &rows[static_cast<usize>(y) * width * CHANNELS];
+			for (u32 x = 0; x < width; x++)
+			{
+				for (const auto& tap : horizontal_taps[x])
+				{
+					for (u32 c = 0; c < CHANNELS; c++)
+						row[x * CHANNELS + c] += tap.weight * source_row[tap.source * CHANNELS + c];
+				}
+			}
+		}
+
+		Image destination{width, height, std::vector<u8>(static_cast<usize>(width) * height * CHANNELS)};
+		for (u32 y = 0; y < height; y++)
+		{
+			u8* destination_row = &destination.pixels[static_cast<usize>(y) * width * CHANNELS];
+			for (u32 x = 0; x < width * CHANNELS; x++)
+			{
+				float value = 0.0f;
+				for (const auto& tap : vertical_taps[y])
+					value += tap.weight * rows[static_cast<usize>(tap.source) * width * CHANNELS + x];
+				destination_row[x] = static_cast<u8>(std::clamp(value + 0.5f, 0.0f, 255.0f));
+			}
+		}
+		return destination;
+	}
+
+	// layers of same-sized mipmapped RGB textures, sampled as a single texture by indexing the layer in the shader
+	class TextureArray
+	{
+		GLuint texture;
+		u32 width, height, layer_count;
+
+	public:
+		TextureArray(const u32 width, const u32 height, const u32 layer_count):
+			texture(0), width(width), height(height), layer_count(layer_count)
+		{
+			if (width == 0 || height == 0 || layer_count == 0)
+				throw std::runtime_error("Texture arrays need a non-zero size.");
+
+			glGenTextures(1, &texture);
+			StateCache::Current().BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, (GLsizei)width, (GLsizei)height, (GLsizei)layer_count, 0,
+				GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+
+		TextureArray(const TextureArray&) = delete;
+		TextureArray& operator=(const TextureArray&) = delete;
+
+		~TextureArray()
+		{
+			glDeleteTextures(1, &texture);
+			StateCache::Current().OnTextureDeleted(texture);
+		}
+
+		// fills a layer, resampling the image when its size differs from the array's
+		// an empty image clears the layer to black, like sampling a missing texture would
+		void SetLayer(const u32 layer, const Image& image)
+		{
+			if (layer >= layer_count)
+				throw std::runtime_error("Texture array layer out of range.");
+
+			Image converted_image;
+			const Image* layer_image = &image;
+			if (image.IsEmpty())
+			{
+				converted_image = Image{width, height, std::vector<u8>(static_cast<usize>(width) * height * Image::CHANNELS, 0)};
+				layer_image = &converted_image;
+			}
+			else if (image.width != width || image.height != height)
+			{
+				converted_image = ResampleImage(image, width, height);
+				layer_image = &converted_image;
+			}
+
+			StateCache::Current().BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+			// rows are tightly packed, whatever the width
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, (GLsizei)width, (GLsizei)height, 1,
+				GL_RGB, GL_UNSIGNED_BYTE, layer_image->pixels.data());
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+
+		// to be called once every layer is set
+		void GenerateMipmaps()
+		{
+			StateCache::Current().BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		}
+
+		void Bind(const u32 unit) const
+		{
+			StateCache::Current().BindTexture(unit, GL_TEXTURE_2D_ARRAY, texture);
+		}
+
+		u32 GetLayerCount() const {return layer_count;}
+		GLuint GetHandle() const {return texture;}
+	};
+}
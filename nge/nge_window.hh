@@ -7,6 +7,7 @@
 
 // engine headers
 #include "build.hh"
+#include "nge_profiler.hh"
 #include "types.hh"
 
 // GL headers
@@ -157,6 +158,7 @@ namespace nge
 		// flips the swapchain's backbuffer
 		void Present() const
 		{
+			NGE_PROFILE_SCOPE("Window::Present");
 			glfwSwapBuffers(window);
 		}
 
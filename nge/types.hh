@@ -10,6 +10,8 @@ using s16 = std::int16_t;
 using u16 = std::uint16_t;
 using s32 = std::int32_t;
 using u32 = std::uint32_t;
+using s64 = std::int64_t;
+using u64 = std::uint64_t;
 using ssize = std::ptrdiff_t;
 using usize = std::size_t;
 using ascii = char;
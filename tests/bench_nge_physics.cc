@@ -0,0 +1,492 @@
+#include "nge_physics.hh"
+#include "nge_physics_diagnostics.hh"
+
+// std headers
+#include <iostream>
+#include <fstream>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <optional>
+#include <cmath>
+
+// usage: bench_nge_physics [--quick] [--json <file>] [--max-n <bodies>] [--max-quadratic-n <bodies>]
+//   --quick            fewer repetitions and smaller problem sizes, used as a smoke test, unless sizes are given
+//   --json <file>      writes machine-readable results to the given file ("-" for stdout, the table then going to stderr)
+//   --max-n            largest body count for linear stages (default 1000000)
+//   --max-quadratic-n  largest body count for O(N^2) stages like the brute-force broadphase (default 10000)
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct BenchmarkConfig
+	{
+		u32 warmup_repetitions = 3;
+		u32 repetitions = 30;
+		double min_repetition_seconds = 0.005; // every repetition loops until at least this much time has passed
+		usize max_n = 1000000;
+		usize max_quadratic_n = 10000;
+		// the human-readable table, moved to stderr when the JSON results go to stdout so that they stay parseable
+		std::ostream* table_output = &std::cout;
+	};
+
+	struct BenchmarkResult
+	{
+		std::string name;
+		std::string variant;
+		usize n;
+		u32 repetitions;
+		u64 iterations_per_repetition;
+		// nanoseconds per iteration
+		double min, mean, p50, p90, p99, max;
+	};
+
+	// how expensive and how accurate an integrator is at a given time step
+	struct TradeoffResult
+	{
+		std::string integrator;
+		double time_step;
+		usize n;
+		double cost_per_simulated_second; // in nanoseconds
+		double max_energy_drift;
+		double max_angular_momentum_drift;
+	};
+
+	// nearest-rank percentile over sorted samples
+	double Percentile(const std::vector<double>& sorted_samples, const double percentile)
+	{
+		const usize rank = static_cast<usize>(std::ceil(percentile / 100.0 * sorted_samples.size()));
+		return sorted_samples[std::clamp<usize>(rank, 1, sorted_samples.size()) - 1];
+	}
+
+	class BenchmarkSuite
+	{
+		const BenchmarkConfig config;
+		std::vector<BenchmarkResult> results;
+		std::vector<TradeoffResult> tradeoffs;
+
+	public:
+		explicit BenchmarkSuite(const BenchmarkConfig& config):
+			config(config)
+		{}
+
+		const BenchmarkConfig& GetConfig() const {return config;}
+		const std::vector<BenchmarkResult>& GetResults() const {return results;}
+
+		void AddTradeoff(const TradeoffResult& tradeoff)
+		{
+			tradeoffs.push_back(tradeoff);
+			*config.table_output << std::format("{:<22} dt={:<10.6f} N={:<6} {:>14.1f} ns/simulated s  energy drift {:<12.3e} angular momentum drift {:.3e}\n",
+				tradeoff.integrator, tradeoff.time_step, tradeoff.n, tradeoff.cost_per_simulated_second,
+				tradeoff.max_energy_drift, tradeoff.max_angular_momentum_drift);
+		}
+
+		// runs the given function repeatedly, setup runs before every repetition and is not timed
+		void Run(const std::string_view name, const std::string_view variant, const usize n,
+			const std::function<void()>& setup, const std::function<void()>& iteration)
+		{
+			// calibrate the number of iterations per repetition, which doubles as a warmup
+			u64 iterations = 1;
+			for (;;)
+			{
+				setup();
+				const auto start = Clock::now();
+				for (u64 i = 0; i < iterations; i++)
+					iteration();
+				const std::chrono::duration<double> elapsed = Clock::now() - start;
+				if (elapsed.count() >= config.min_repetition_seconds || iterations >= (u64(1) << 30))
+					break;
+				iterations *= 2;
+			}
+
+			for (u32 warmup = 0; warmup < config.warmup_repetitions; warmup++)
+			{
+				setup();
+				for (u64 i = 0; i < iterations; i++)
+					iteration();
+			}
+
+			std::vector<double> samples;
+			samples.reserve(config.repetitions);
+			for (u32 repetition = 0; repetition < config.repetitions; repetition++)
+			{
+				setup();
+				const auto start = Clock::now();
+				for (u64 i = 0; i < iterations; i++)
+					iteration();
+				const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+				samples.push_back(elapsed.count() / static_cast<double>(iterations));
+			}
+			std::sort(samples.begin(), samples.end());
+
+			double sum = 0.0;
+			for (const double sample : samples)
+				sum += sample;
+
+			const BenchmarkResult& result = results.emplace_back(BenchmarkResult
+			{
+				std::string(name), std::string(variant), n, config.repetitions, iterations,
+				samples.front(), sum / samples.size(), Percentile(samples, 50.0), Percentile(samples, 90.0),
+				Percentile(samples, 99.0), samples.back()
+			});
+			*config.table_output << std::format("{:<28} {:<22} N={:<8} p50 {:>14.1f} ns  p90 {:>14.1f} ns  p99 {:>14.1f} ns\n",
+				result.name, result.variant, result.n, result.p50, result.p90, result.p99);
+		}
+
+		void WriteJSON(std::ostream& output) const
+		{
+			output << "{\n";
+			output << "\t\"suite\": \"nge_physics\",\n";
+			output << "\t\"unit\": \"ns/iteration\",\n";
+			output << std::format("\t\"warmup_repetitions\": {},\n", config.warmup_repetitions);
+			output << "\t\"results\": [\n";
+			for (usize i = 0; i < results.size(); i++)
+			{
+				const BenchmarkResult& result = results[i];
+				output << std::format("\t\t{{\"name\": \"{}\", \"variant\": \"{}\", \"n\": {}, \"repetitions\": {}, "
+					"\"iterations_per_repetition\": {}, \"min\": {}, \"mean\": {}, \"p50\": {}, \"p90\": {}, "
+					"\"p99\": {}, \"max\": {}}}{}\n",
+					result.name, result.variant, result.n, result.repetitions, result.iterations_per_repetition,
+					result.min, result.mean, result.p50, result.p90, result.p99, result.max,
+					i + 1 < results.size() ? "," : "");
+			}
+			output << "\t],\n";
+			output << "\t\"integrator_tradeoffs\": [\n";
+			for (usize i = 0; i < tradeoffs.size(); i++)
+			{
+				const TradeoffResult& tradeoff = tradeoffs[i];
+				output << std::format("\t\t{{\"integrator\": \"{}\", \"time_step\": {}, \"n\": {}, "
+					"\"cost_per_simulated_second\": {}, \"max_energy_drift\": {}, \"max_angular_momentum_drift\": {}}}{}\n",
+					tradeoff.integrator, tradeoff.time_step, tradeoff.n, tradeoff.cost_per_simulated_second,
+					tradeoff.max_energy_drift, tradeoff.max_angular_momentum_drift, i + 1 < tradeoffs.size() ? "," : "");
+			}
+			output << "\t]\n";
+			output << "}\n";
+		}
+	};
+
+	// problem sizes from 10 up to the given limit, one per decade
+	std::vector<usize> Decades(const usize max_n)
+	{
+		std::vector<usize> sizes;
+		for (usize n = 10; n <= max_n; n *= 10)
+			sizes.push_back(n);
+		return sizes;
+	}
+
+	// bodies on a jittered lattice, spaced so that only a few of them overlap
+	std::vector<nge::physics::Body> MakeSparseBodies(const usize n, const u32 seed = 42)
+	{
+		std::mt19937 generator(seed);
+		std::uniform_real_distribution<float> jitter(-0.25f, 0.25f);
+		std::uniform_real_distribution<float> mass(1.0f, 10.0f);
+
+		const usize side = static_cast<usize>(std::ceil(std::cbrt(static_cast<double>(n))));
+		std::vector<nge::physics::Body> bodies;
+		bodies.reserve(n);
+		for (usize i = 0; i < n; i++)
+		{
+			const nge::math::Vector3 cell(i % side, (i / side) % side, i / (side * side));
+			const nge::math::Vector3 jittered = cell * 2.0f + nge::math::Vector3(jitter(generator), jitter(generator), jitter(generator));
+			bodies.emplace_back(jittered, mass(generator), 0.5f);
+		}
+		return bodies;
+	}
+
+	void AddSparseBodies(nge::physics::Simulation& sim, const usize n)
+	{
+		for (const auto& body : MakeSparseBodies(n))
+			sim.AddSphericalBody(body.GetLocation(), body.GetMass(), body.GetRadius());
+	}
+
+	struct Integrator
+	{
+		std::string_view name;
+		nge::physics::Integrator integrator;
+	};
+	constexpr Integrator INTEGRATORS[] =
+	{
+		{"explicit_euler", nge::physics::Integrator::ExplicitEuler},
+		{"semi_implicit_euler", nge::physics::Integrator::SemiImplicitEuler},
+		{"velocity_verlet", nge::physics::Integrator::VelocityVerlet},
+	};
+
+	void BenchmarkTick(BenchmarkSuite& suite)
+	{
+		const BenchmarkConfig& config = suite.GetConfig();
+
+		struct Variant
+		{
+			std::string_view name;
+			nge::physics::CollisionResponse response;
+			float gravitational_constant;
+		};
+		constexpr Variant variants[] =
+		{
+			{"uniform_field/elastic", nge::physics::CollisionResponse::Elastic, 0.0f},
+			{"direct_sum/elastic", nge::physics::CollisionResponse::Elastic, 1.0f},
+			{"direct_sum/accretion", nge::physics::CollisionResponse::Accretion, 1.0f},
+		};
+
+		for (const Variant& variant : variants)
+		{
+			// the broadphase is brute-force, so every variant of a whole tick is quadratic
+			// note that ticks keep evolving the same system, so accretion variants measure a shrinking N
+			for (const usize n : Decades(std::min(config.max_n, config.max_quadratic_n)))
+			{
+				nge::physics::Simulation sim;
+				suite.Run("Simulation::Tick", variant.name, n,
+					[&sim, &variant, n]
+					{
+						sim.Reset();
+						sim.SetCollisionResponse(variant.response);
+						sim.SetMutualGravity(variant.gravitational_constant, 0.1f);
+						AddSparseBodies(sim, n);
+					},
+					[&sim]
+					{
+						sim.Tick(1.0f / 60.0f);
+					});
+			}
+		}
+	}
+
+	void BenchmarkGravitySolvers(BenchmarkSuite& suite)
+	{
+		const BenchmarkConfig& config = suite.GetConfig();
+
+		// a zero gravitational constant only clears the accelerations, leaving the uniform field
+		for (const usize n : Decades(config.max_n))
+		{
+			std::vector<nge::physics::Body> bodies = MakeSparseBodies(n);
+			suite.Run("ComputeMutualGravity", "uniform_field", n, []{},
+				[&bodies]
+				{
+					nge::physics::Simulation::ComputeMutualGravity(bodies, 0.0f, 0.0f);
+				});
+		}
+
+		for (const usize n : Decades(config.max_quadratic_n))
+		{
+			std::vector<nge::physics::Body> bodies = MakeSparseBodies(n);
+			suite.Run("ComputeMutualGravity", "direct_sum", n, []{},
+				[&bodies]
+				{
+					nge::physics::Simulation::ComputeMutualGravity(bodies, 1.0f, 0.1f);
+				});
+		}
+	}
+
+	void BenchmarkBroadphases(BenchmarkSuite& suite)
+	{
+		const BenchmarkConfig& config = suite.GetConfig();
+
+		for (const usize n : Decades(config.max_quadratic_n))
+		{
+			std::vector<nge::physics::Body> bodies = MakeSparseBodies(n);
+			std::vector<std::pair<nge::physics::Body*, nge::physics::Body*>> collisions;
+			suite.Run("FindPotentialCollisions", "brute_force", n, []{},
+				[&bodies, &collisions]
+				{
+					collisions.clear();
+					nge::physics::Simulation::FindPotentialCollisions(bodies, collisions);
+				});
+		}
+	}
+
+	void BenchmarkIntegrator(BenchmarkSuite& suite)
+	{
+		const BenchmarkConfig& config = suite.GetConfig();
+
+		// without mutual gravity, this is the bare cost of every integrator
+		for (const Integrator& integrator : INTEGRATORS)
+		{
+			for (const usize n : Decades(config.max_n))
+			{
+				std::vector<nge::physics::Body> bodies = MakeSparseBodies(n);
+				suite.Run("IntegrateBodies", integrator.name, n, []{},
+					[&bodies, &integrator]
+					{
+						nge::physics::Simulation::IntegrateBodies(bodies, 1.0f / 60.0f, integrator.integrator);
+					});
+			}
+		}
+	}
+
+	// light bodies on circular orbits around a heavy one, isolated from any external force
+	void AddOrbitingBodies(nge::physics::Simulation& sim, const usize n, const float gravitational_constant)
+	{
+		constexpr float CENTRAL_MASS = 1000.0f;
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> orbit_radius(5.0f, 50.0f);
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+		const auto sun = sim.AddSphericalBody(nge::math::Vector3(0.0f), CENTRAL_MASS, 0.01f);
+		sim.SetBodyForce(sun, nge::math::Vector3(0.0f));
+		for (usize i = 1; i < n; i++)
+		{
+			const float radius = orbit_radius(generator);
+			const float phase = angle(generator);
+			const nge::math::Vector3 direction(std::cos(phase), 0.0f, std::sin(phase));
+			const auto body = sim.AddSphericalBody(direction * radius, 0.001f, 0.01f);
+			sim.SetBodyForce(body, nge::math::Vector3(0.0f));
+			const float speed = std::sqrt(gravitational_constant * CENTRAL_MASS / radius);
+			sim.SetBodyVelocity(body, nge::math::Vector3(-direction.z, 0.0f, direction.x) * speed);
+		}
+	}
+
+	// cost versus accuracy of every integrator over a range of time steps, to pick the cheapest one that is good enough
+	void BenchmarkIntegratorTradeoffs(BenchmarkSuite& suite)
+	{
+		const BenchmarkConfig& config = suite.GetConfig();
+		constexpr float GRAVITATIONAL_CONSTANT = 1.0f;
+		constexpr float TIME_STEPS[] = {1.0f / 15.0f, 1.0f / 30.0f, 1.0f / 60.0f, 1.0f / 120.0f, 1.0f / 240.0f};
+		const usize n = std::min<usize>(config.max_quadratic_n, 64);
+		const nge::timing::Seconds simulated_time = config.repetitions >= 30 ? 20.0f : 2.0f;
+
+		for (const Integrator& integrator : INTEGRATORS)
+		{
+			for (const float time_step : TIME_STEPS)
+			{
+				nge::physics::Simulation sim;
+				sim.SetIntegrator(integrator.integrator);
+				sim.SetMutualGravity(GRAVITATIONAL_CONSTANT);
+				AddOrbitingBodies(sim, n, GRAVITATIONAL_CONSTANT);
+
+				// only time the ticks, the diagnostics are sampled in between
+				nge::physics::ConservationMonitor monitor(1);
+				monitor.Sample(sim);
+				const u32 tick_count = static_cast<u32>(simulated_time / time_step);
+				Clock::duration tick_time(0);
+				for (u32 tick = 0; tick < tick_count; tick++)
+				{
+					const auto start = Clock::now();
+					sim.Tick(time_step);
+					tick_time += Clock::now() - start;
+					monitor.Sample(sim);
+				}
+
+				const std::chrono::duration<double, std::nano> elapsed = tick_time;
+				const auto& statistics = monitor.GetStatistics();
+				suite.AddTradeoff(TradeoffResult
+				{
+					std::string(integrator.name), time_step, n, elapsed.count() / (tick_count * time_step),
+					statistics.max_energy_drift, statistics.max_angular_momentum_drift
+				});
+			}
+		}
+	}
+
+	void BenchmarkCollisionResponse(BenchmarkSuite& suite)
+	{
+		const BenchmarkConfig& config = suite.GetConfig();
+
+		// head-on pairs of overlapping bodies, reset before every repetition so that every contact is resolved
+		// n counts the bodies like every other benchmark, the variants give the pairs resolved
+		for (const usize n : Decades(config.max_n))
+		{
+			const usize pair_count = n / 2;
+			std::vector<nge::physics::Body> pristine;
+			pristine.reserve(pair_count * 2);
+			for (usize i = 0; i < pair_count; i++)
+			{
+				const nge::math::Vector3 center(static_cast<float>(i) * 4.0f, 0.0f, 0.0f);
+				pristine.emplace_back(center, 2.0f, 1.0f);
+				pristine.emplace_back(center + nge::math::Vector3(1.5f, 0.0f, 0.0f), 1.0f, 1.0f);
+			}
+
+			std::vector<nge::physics::Body> bodies;
+			suite.Run("Body::PerformCollisionResponse", std::format("elastic, {} pairs", pair_count), n,
+				[&bodies, &pristine]
+				{
+					bodies = pristine;
+				},
+				[&bodies, pair_count]
+				{
+					for (usize i = 0; i < pair_count; i++)
+						bodies[i * 2].PerformCollisionResponse(bodies[i * 2 + 1]);
+				});
+
+			suite.Run("Body::MergeWith", std::format("accretion, {} pairs", pair_count), n,
+				[&bodies, &pristine]
+				{
+					bodies = pristine;
+				},
+				[&bodies, pair_count]
+				{
+					for (usize i = 0; i < pair_count; i++)
+						bodies[i * 2].MergeWith(bodies[i * 2 + 1]);
+				});
+		}
+	}
+}
+
+int main(const int argc, const char** argv)
+{
+	BenchmarkConfig config;
+	std::string json_path;
+	bool is_quick = false;
+	// explicit sizes win over the --quick ones, whatever the order of the options
+	std::optional<usize> max_n, max_quadratic_n;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view argument = argv[i];
+		if (argument == "--quick")
+			is_quick = true;
+		else if (argument == "--json" && i + 1 < argc)
+			json_path = argv[++i];
+		else if (argument == "--max-n" && i + 1 < argc)
+			max_n = std::stoull(argv[++i]);
+		else if (argument == "--max-quadratic-n" && i + 1 < argc)
+			max_quadratic_n = std::stoull(argv[++i]);
+		else
+		{
+			std::cerr << "Unknown argument: " << argument << '\n';
+			return 1;
+		}
+	}
+
+	if (is_quick)
+	{
+		config.warmup_repetitions = 1;
+		config.repetitions = 5;
+		config.min_repetition_seconds = 0.0005;
+		config.max_n = 10000;
+		config.max_quadratic_n = 1000;
+	}
+	config.max_n = max_n.value_or(config.max_n);
+	config.max_quadratic_n = max_quadratic_n.value_or(config.max_quadratic_n);
+
+	if (json_path == "-")
+		config.table_output = &std::cerr;
+
+	BenchmarkSuite suite(config);
+	BenchmarkTick(suite);
+	BenchmarkGravitySolvers(suite);
+	BenchmarkBroadphases(suite);
+	BenchmarkIntegrator(suite);
+	BenchmarkCollisionResponse(suite);
+	BenchmarkIntegratorTradeoffs(suite);
+
+	if (json_path == "-")
+		suite.WriteJSON(std::cout);
+	else if (!json_path.empty())
+	{
+		std::ofstream json_file(json_path);
+		if (!json_file.is_open())
+		{
+			std::cerr << "Failed to open " << json_path << " for writing.\n";
+			return 1;
+		}
+		suite.WriteJSON(json_file);
+	}
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+#include "orbits.hh"
+#include "nge_pipeline.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <vector>
+#include <cmath>
+#include <span>
+#include <thread>
+
+// the sun, the earth and the moon as the game starts them
+static std::vector<OrbitalBody> MakeEarthAndMoon()
+{
+	return {
+		{100000000, 5, 0, 0, 0, 0, 0, 0},
+		{100, 1, 50, 0, 0, 0.0001, 0.0003, 0},
+		{1, .2, 51.5, -1.5, 0, 0.0001, 0.0003 + 0.00008, 0},
+	};
+}
+
+int main()
+{
+	constexpr nge::timing::Seconds FRAME_TIME = 1.0f / 60.0f;
+
+	// the earth pulls the moon as if it were 100 times closer, which the softening must barely change
+	{
+		// without the sun, whose pull on the moon is about a sixth of the earth's
+		std::vector<OrbitalBody> bodies = MakeEarthAndMoon();
+		bodies.erase(bodies.begin());
+		const OrbitalBody moon = bodies[1];
+		const double distance = bodies[1].DistanceFrom(bodies[0]) / 100;
+		const double expected_pull = 100 * (6.674 / 100000000000) / (distance * distance) * FRAME_TIME;
+		StepOrbits(bodies, FRAME_TIME);
+		const double pull = moon.vX - bodies[1].vX;
+		std::cout << std::format("Pull of the earth on the moon: {:.4g}, {:.4g} without softening\n", pull, expected_pull);
+		if (std::abs(pull - expected_pull) > expected_pull * 0.01)
+		{
+			std::cerr << "The softening must apply to the real distance, not the shortened one\n";
+			return 1;
+		}
+	}
+
+	// so the moon never gets away from the earth, until it falls on it
+	std::vector<OrbitalBody> bodies = MakeEarthAndMoon();
+	const float start_distance = bodies[2].DistanceFrom(bodies[1]);
+	float max_distance = start_distance;
+	u32 step = 0;
+	for (; step < 60 * 60 && bodies.size() == 3; step++)
+	{
+		max_distance = std::max(max_distance, bodies[2].DistanceFrom(bodies[1]));
+		StepOrbits(bodies, FRAME_TIME);
+	}
+	std::cout << std::format("The moon stayed within {:.3f} of the earth, starting at {:.3f}, for {} steps\n", max_distance,
+		start_distance, step);
+	if (max_distance > start_distance * 1.01f)
+	{
+		std::cerr << "The moon must stay bound to the earth\n";
+		return 1;
+	}
+	if (bodies.size() == 2 && bodies[1].mass != 101)
+	{
+		std::cerr << "The moon must only ever merge into the earth\n";
+		return 1;
+	}
+
+	// frames of varying times, stepped one by one and then through a simulation thread, which is requested them far
+	// faster than it can step them, so that most of them reach it in batches
+	constexpr u32 FRAME_COUNT = 2000;
+	std::vector<nge::timing::Seconds> frame_times(FRAME_COUNT);
+	for (u32 frame = 0; frame < FRAME_COUNT; frame++)
+		frame_times[frame] = FRAME_TIME * (1.0f + 0.5f * std::sin(static_cast<float>(frame)));
+	std::vector<OrbitalBody> stepped_bodies = MakeEarthAndMoon();
+	for (const nge::timing::Seconds time : frame_times)
+		StepOrbits(stepped_bodies, time);
+
+	std::vector<OrbitalBody> simulated_bodies = MakeEarthAndMoon();
+	u32 simulation_step_count = 0;
+	{
+		u32 simulated_frame_count = 0;
+		nge::SimulationThread<u32> simulation([&](const std::span<const nge::timing::Seconds> times, u32& snapshot)
+		{
+			simulation_step_count++;
+			for (const nge::timing::Seconds time : times)
+				StepOrbits(simulated_bodies, time);
+			simulated_frame_count += static_cast<u32>(times.size());
+			snapshot = simulated_frame_count;
+		});
+		simulation.Start();
+		for (const nge::timing::Seconds time : frame_times)
+			simulation.Advance(time);
+		while (simulation.GetLatest() < FRAME_COUNT)
+			std::this_thread::yield();
+	}
+	std::cout << std::format("Simulated {} frames in {} steps\n", FRAME_COUNT, simulation_step_count);
+	bool is_same_state = stepped_bodies.size() == simulated_bodies.size();
+	for (usize i = 0; is_same_state && i < stepped_bodies.size(); i++)
+	{
+		const OrbitalBody& a = stepped_bodies[i];
+		const OrbitalBody& b = simulated_bodies[i];
+		is_same_state = a.mass == b.mass && a.radius == b.radius && a.x == b.x && a.y == b.y && a.z == b.z &&
+			a.vX == b.vX && a.vY == b.vY && a.vZ == b.vZ;
+	}
+	if (!is_same_state)
+	{
+		std::cerr << "Frames handed to the simulation together must end in the same state as frames stepped one by one\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include "nge_culling.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <random>
+#include <chrono>
+#include <cmath>
+
+int main()
+{
+	// a camera at the origin looking down -Z, like the default GL one
+	const mat4 view_projection = perspective(radians(45.0f), 1.6f, 0.1f, 1000.0f) *
+		lookAt(vec3(0.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f));
+	const auto frustum = nge::graphics::Frustum::FromViewProjection(view_projection);
+
+	struct Case
+	{
+		vec3 center;
+		float radius;
+		bool is_visible;
+	};
+	const Case cases[] =
+	{
+		{vec3(0.0f, 0.0f, -10.0f), 1.0f, true}, // straight ahead
+		{vec3(0.0f, 0.0f, 10.0f), 1.0f, false}, // behind
+		{vec3(0.0f, 0.0f, 0.5f), 1.0f, true}, // around the camera
+		{vec3(100.0f, 0.0f, -10.0f), 1.0f, false}, // far on the right
+		{vec3(0.0f, 0.0f, -1100.0f), 50.0f, false}, // beyond the far plane
+		{vec3(0.0f, 0.0f, -1020.0f), 50.0f, true}, // crossing the far plane
+	};
+	for (const auto& c : cases)
+	{
+		nge::graphics::BoundingSpheres spheres;
+		spheres.Add(c.center, c.radius);
+		std::vector<u32> visible_indices;
+		spheres.Cull(frustum, visible_indices);
+		if (visible_indices.empty() == c.is_visible || frustum.IsSphereVisible(c.center, c.radius) != c.is_visible)
+		{
+			std::cerr << std::format("Sphere at ({} {} {}) of radius {} should be {}\n", c.center.x, c.center.y,
+				c.center.z, c.radius, c.is_visible ? "visible" : "culled");
+			return 1;
+		}
+	}
+
+	// many spheres added in spatially coherent order, small clusters scattered all around the camera
+	constexpr u32 SPHERE_COUNT = 1'000'000;
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> cluster_distribution(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> offset_distribution(-5.0f, 5.0f);
+	std::uniform_real_distribution<float> radius_distribution(0.1f, 2.0f);
+
+	nge::graphics::BoundingSpheres spheres;
+	spheres.Reserve(SPHERE_COUNT);
+	std::vector<vec4> reference;
+	reference.reserve(SPHERE_COUNT);
+	vec3 cluster_center(0.0f);
+	for (u32 i = 0; i < SPHERE_COUNT; i++)
+	{
+		if (i % nge::graphics::BoundingSpheres::GROUP_SIZE == 0)
+			cluster_center = vec3(cluster_distribution(generator), cluster_distribution(generator), cluster_distribution(generator));
+		const vec3 center = cluster_center +
+			vec3(offset_distribution(generator), offset_distribution(generator), offset_distribution(generator));
+		const float radius = radius_distribution(generator);
+		spheres.Add(center, radius);
+		reference.emplace_back(center, radius);
+	}
+
+	std::vector<u32> visible_indices;
+	visible_indices.reserve(SPHERE_COUNT);
+	spheres.Cull(frustum, visible_indices); // warm up
+
+	constexpr u32 REPEAT_COUNT = 10;
+	const auto start = std::chrono::steady_clock::now();
+	for (u32 repeat = 0; repeat < REPEAT_COUNT; repeat++)
+		spheres.Cull(frustum, visible_indices);
+	const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+	std::cout << std::format("Culled {} spheres in {:.3f} ms, {} visible\n", SPHERE_COUNT, duration.count() / REPEAT_COUNT,
+		visible_indices.size());
+
+	// the hierarchical SIMD test must agree with testing every sphere on its own
+	usize next = 0;
+	for (u32 i = 0; i < SPHERE_COUNT; i++)
+	{
+		const bool is_visible = next < visible_indices.size() && visible_indices[next] == i;
+		if (is_visible)
+			next++;
+		if (is_visible != frustum.IsSphereVisible(vec3(reference[i]), reference[i].w))
+		{
+			std::cerr << std::format("Sphere {} wrongly {}\n", i, is_visible ? "visible" : "culled");
+			return 1;
+		}
+	}
+	if (next != visible_indices.size())
+	{
+		std::cerr << "Visible indices are not unique and increasing\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+#include "nge_dynamic_resolution.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <deque>
+
+using nge::graphics::ResolutionScaler;
+using nge::graphics::GpuFrameTimer;
+
+// GPU time of a frame whose pixel work costs pixel_time at full resolution, on top of a fixed_time independent of it
+static float GetFrameTime(const float scale, const float pixel_time, const float fixed_time)
+{
+	return fixed_time + pixel_time * scale * scale;
+}
+
+int main()
+{
+	constexpr float BUDGET = 0.014f;
+	constexpr float FIXED_TIME = 0.002f;
+	ResolutionScaler scaler(BUDGET);
+
+	// each frame's time is only known FRAME_LATENCY frames later, like with GpuFrameTimer
+	std::deque<float> pending_times;
+	auto run = [&](const u32 frame_count, const float pixel_time, float& max_time, u32& change_count)
+	{
+		max_time = 0.0f;
+		change_count = 0;
+		for (u32 frame = 0; frame < frame_count; frame++)
+		{
+			const float previous_scale = scaler.GetScale();
+			if (pending_times.size() == GpuFrameTimer::FRAME_LATENCY)
+			{
+				scaler.Update(pending_times.front());
+				pending_times.pop_front();
+			}
+			if (scaler.GetScale() != previous_scale)
+				change_count++;
+			const float time = GetFrameTime(scaler.GetScale(), pixel_time, FIXED_TIME);
+			pending_times.push_back(time);
+			max_time = std::max(max_time, time);
+		}
+	};
+
+	// a scene too heavy for the budget at full resolution settles on a lower resolution which holds it
+	float max_time = 0.0f;
+	u32 change_count = 0;
+	run(300, 0.02f, max_time, change_count);
+	run(600, 0.02f, max_time, change_count);
+	std::cout << std::format("Heavy scene: scale {:.3f}, at most {:.2f} ms per frame\n", scaler.GetScale(), max_time * 1000.0f);
+	if (scaler.GetScale() >= 1.0f || scaler.GetScale() < ResolutionScaler::MIN_SCALE || max_time > BUDGET)
+	{
+		std::cerr << "The resolution must drop until frames are within budget\n";
+		return 1;
+	}
+	if (change_count != 0)
+	{
+		std::cerr << std::format("The resolution changed {} times once settled\n", change_count);
+		return 1;
+	}
+
+	// a scene far too heavy is capped at the lowest resolution
+	run(300, 0.2f, max_time, change_count);
+	std::cout << std::format("Overloaded scene: scale {:.3f}\n", scaler.GetScale());
+	if (scaler.GetScale() != ResolutionScaler::MIN_SCALE)
+	{
+		std::cerr << "The resolution must not drop below the minimum\n";
+		return 1;
+	}
+
+	// and once the scene is light again the full resolution comes back, without ever going over budget on the way
+	run(1000, 0.005f, max_time, change_count);
+	std::cout << std::format("Light scene: scale {:.3f} after {} changes\n", scaler.GetScale(), change_count);
+	if (scaler.GetScale() != 1.0f || max_time > BUDGET)
+	{
+		std::cerr << "The resolution must rise back to the full one within budget\n";
+		return 1;
+	}
+
+	return 0;
+}
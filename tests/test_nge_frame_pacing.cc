@@ -0,0 +1,82 @@
+#include "nge_headless.hh"
+#include "nge_frame_pacing.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <array>
+#include <utility>
+
+using nge::FramePacer;
+using nge::LatencyReport;
+
+// runs frames of clears in the order the game does, and reports their latency and the final delay of their starts
+static std::pair<LatencyReport, nge::timing::Seconds> RunFrames(const FramePacer::Settings& settings, const u32 frame_count)
+{
+	nge::HeadlessWindow window(nge::Extent2D(64, 64), frame_count);
+	FramePacer frame_pacer(settings);
+	const bool is_low_latency = settings.max_frames_in_flight > 0;
+	while (!window.ShouldClose())
+	{
+		frame_pacer.BeginFrame();
+		if (is_low_latency)
+		{
+			window.ProcessEvents();
+			frame_pacer.OnInputPolled();
+		}
+
+		glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		frame_pacer.OnFrameReady();
+		window.Present();
+		frame_pacer.OnFramePresented();
+		if (!is_low_latency)
+		{
+			window.ProcessEvents();
+			frame_pacer.OnInputPolled();
+		}
+	}
+	glFinish();
+
+	return {frame_pacer.GetLatencyReport(), frame_pacer.GetDelay()};
+}
+
+int main()
+{
+	constexpr u32 FRAME_COUNT = 100;
+	const std::array<std::pair<const char*, FramePacer::Settings>, 3> modes{{
+		{"driver queued", {0, false}},
+		{"low latency", {1, false}},
+		{"just in time", {1, true}},
+	}};
+	for (const auto& [name, settings] : modes)
+	{
+		const auto [report, delay] = RunFrames(settings, FRAME_COUNT);
+		std::cout << std::format("{}: {} frames, latency {:.3f} ms median, {:.3f} ms 90th, {:.3f} ms 99th, {:.3f} ms max\n",
+			name, report.sample_count, report.median * 1000.0f, report.percentile_90 * 1000.0f,
+			report.percentile_99 * 1000.0f, report.max * 1000.0f);
+
+		// every frame is measured once the GPU is done, and presented after its input was polled
+		if (report.sample_count != FRAME_COUNT)
+		{
+			std::cerr << std::format("Measured {} frames of {}\n", report.sample_count, FRAME_COUNT);
+			return 1;
+		}
+		if (!(0.0f < report.median && report.median <= report.percentile_90 &&
+			report.percentile_90 <= report.percentile_99 && report.percentile_99 <= report.max))
+		{
+			std::cerr << "The latency percentiles must be positive and in order\n";
+			return 1;
+		}
+
+		// without vsync frames are presented as soon as they are ready, so there is nothing to wait for
+		if (delay != 0.0f)
+		{
+			std::cerr << std::format("Frames were delayed by {:.3f} ms without vsync\n", delay * 1000.0f);
+			return 1;
+		}
+	}
+
+	return 0;
+}
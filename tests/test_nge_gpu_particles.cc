@@ -0,0 +1,99 @@
+#include "nge_headless.hh"
+#include "nge_gpu_particles.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+using nge::graphics::GpuParticle;
+using nge::graphics::GpuParticleSystem;
+
+// particles of the last step, read back from the GPU
+static std::vector<GpuParticle> ReadParticles(const GpuParticleSystem& system)
+{
+	std::vector<GpuParticle> particles(system.GetCapacity());
+	glBindBuffer(GL_ARRAY_BUFFER, system.GetBuffer());
+	glGetBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(particles.size() * sizeof(GpuParticle)), particles.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return particles;
+}
+
+static u32 CountAlive(const std::vector<GpuParticle>& particles)
+{
+	u32 count = 0;
+	for (const GpuParticle& particle : particles)
+		count += particle.position_and_life.w > 0.0f;
+	return count;
+}
+
+int main()
+{
+	// runs from bin/, where the shaders are, with whatever EGL driver there is (llvmpipe on build machines)
+	const nge::HeadlessWindow window(nge::Extent2D(16, 16), 1);
+	const nge::graphics::Shader update_shader("shaders/particle_update.vs",
+		std::span(GpuParticleSystem::UPDATE_VARYINGS));
+
+	// a particle lives for a second, so with steps of an eighth of a second only the last 7 steps' particles live on
+	constexpr u32 CAPACITY = 1000;
+	constexpr u32 SPAWN_COUNT = 50;
+	constexpr u32 STEP_COUNT = 10;
+	constexpr float STEP_TIME = 0.125f;
+	const vec3 origin(-5.0f);
+	GpuParticleSystem system(CAPACITY, update_shader, 1);
+	GpuParticleSystem same_seed_system(CAPACITY, update_shader, 1);
+	GpuParticleSystem other_seed_system(CAPACITY, update_shader, 2);
+	for (u32 step = 0; step < STEP_COUNT; step++)
+	{
+		system.Update(STEP_TIME, SPAWN_COUNT, origin);
+		same_seed_system.Update(STEP_TIME, SPAWN_COUNT, origin);
+		other_seed_system.Update(STEP_TIME, SPAWN_COUNT, origin);
+	}
+	// stopped time changes nothing
+	system.Update(0.0f, SPAWN_COUNT, origin);
+
+	const auto particles = ReadParticles(system);
+	const u32 alive_count = CountAlive(particles);
+	std::cout << std::format("{} particles alive after {} steps\n", alive_count, STEP_COUNT);
+	if (alive_count != 7 * SPAWN_COUNT)
+	{
+		std::cerr << std::format("Expected {} particles alive\n", 7 * SPAWN_COUNT);
+		return 1;
+	}
+	for (const GpuParticle& particle : particles)
+	{
+		// spawned in a 10 unit cube from the origin, and moving less than 5 units per second on every axis
+		for (u32 axis = 0; axis < 3; axis++)
+		{
+			const float position = particle.position_and_life[axis];
+			if (particle.position_and_life.w > 0.0f && !(position >= origin[axis] - 5.0f && position <= origin[axis] + 15.0f))
+			{
+				std::cerr << std::format("Particle at {} on axis {}, too far from where they spawn\n", position, axis);
+				return 1;
+			}
+		}
+	}
+
+	// the same seed gives the same particles, another seed other ones
+	const auto same_seed_particles = ReadParticles(same_seed_system);
+	const auto other_seed_particles = ReadParticles(other_seed_system);
+	if (std::memcmp(particles.data(), same_seed_particles.data(), particles.size() * sizeof(GpuParticle)) != 0 ||
+		std::memcmp(particles.data(), other_seed_particles.data(), particles.size() * sizeof(GpuParticle)) == 0)
+	{
+		std::cerr << "Particles must only depend on the seed\n";
+		return 1;
+	}
+
+	// spawning more than the capacity replaces the oldest particles, and never leaves a slot dead
+	GpuParticleSystem small_system(100, update_shader);
+	small_system.Update(STEP_TIME, 60, origin);
+	small_system.Update(STEP_TIME, 60, origin);
+	if (CountAlive(ReadParticles(small_system)) != 100)
+	{
+		std::cerr << "Every particle must be alive once the spawned ones wrap around\n";
+		return 1;
+	}
+	return 0;
+}
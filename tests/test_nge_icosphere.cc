@@ -0,0 +1,133 @@
+#include "nge_icosphere.hh"
+#include "nge_impostor.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <cmath>
+#include <vector>
+#include <stdexcept>
+
+int main()
+{
+	for (u32 subdivision_count = 0; subdivision_count <= 5; subdivision_count++)
+	{
+		const auto mesh = nge::graphics::GenerateIcosphere(subdivision_count);
+		const usize triangle_count = mesh.vertex_indices.size() / 3;
+		std::cout << std::format("{} subdivisions: {} vertices, {} triangles\n", subdivision_count, mesh.vertices.size(),
+			triangle_count);
+
+		if (triangle_count != 20u << (2 * subdivision_count))
+		{
+			std::cerr << "Unexpected triangle count\n";
+			return 1;
+		}
+
+		for (const auto& vertex : mesh.vertices)
+		{
+			if (std::fabs(length(vertex.position) - 1.0f) > 1e-5f || std::fabs(dot(vertex.normal, vertex.tangent)) > 1e-5f)
+			{
+				std::cerr << "Vertices must lie on the unit sphere, with their tangent orthogonal to their normal\n";
+				return 1;
+			}
+		}
+
+		for (usize t = 0; t < mesh.vertex_indices.size(); t += 3)
+		{
+			const auto& a = mesh.vertices[mesh.vertex_indices[t]];
+			const auto& b = mesh.vertices[mesh.vertex_indices[t + 1]];
+			const auto& c = mesh.vertices[mesh.vertex_indices[t + 2]];
+
+			// counter-clockwise seen from outside, like every front face
+			if (dot(cross(b.position - a.position, c.position - a.position), a.position + b.position + c.position) <= 0.0f)
+			{
+				std::cerr << std::format("Triangle {} faces inwards\n", t / 3);
+				return 1;
+			}
+
+			// no triangle may stretch across the texture seam
+			const float u_span = std::fmax(std::fmax(a.texcoord.x, b.texcoord.x), c.texcoord.x) -
+				std::fmin(std::fmin(a.texcoord.x, b.texcoord.x), c.texcoord.x);
+			if (u_span > 0.25f)
+			{
+				std::cerr << std::format("Triangle {} spans {} of the texture width\n", t / 3, u_span);
+				return 1;
+			}
+		}
+
+		// packing loses less than the precision of each attribute, the unit sphere fitting the packed positions
+		std::vector<nge::graphics::PackedVertexFormat> packed_vertices;
+		nge::graphics::PackVertices(mesh.vertices, packed_vertices);
+		if (packed_vertices.size() != mesh.vertices.size())
+		{
+			std::cerr << "Packing the unit sphere must keep its vertices\n";
+			return 1;
+		}
+		for (usize i = 0; i < mesh.vertices.size(); i++)
+		{
+			const auto& vertex = mesh.vertices[i];
+			const auto& packed = packed_vertices[i];
+			const auto unpack_snorm10 = [](const u32 value, const u32 axis)
+			{
+				// sign extends the 10 bits of the axis
+				return std::fmax(static_cast<float>(static_cast<s32>(value << (22 - axis * 10)) >> 22) / 511.0f, -1.0f);
+			};
+			// errors in units of the last bit kept, rounding being off by half of one at most
+			float error = 0.0f;
+			for (u32 axis = 0; axis < 3; axis++)
+			{
+				error = std::fmax(error, std::fabs(packed.position[axis] / 32767.0f - vertex.position[axis]) * 32767.0f);
+				error = std::fmax(error, std::fabs(unpack_snorm10(packed.normal, axis) - vertex.normal[axis]) * 511.0f);
+				error = std::fmax(error, std::fabs(unpack_snorm10(packed.tangent, axis) - vertex.tangent[axis]) * 511.0f);
+			}
+			// halves are 2^-10 apart between 1 and 2, and closer below
+			const vec2 texcoord_error = abs(unpackHalf2x16(packed.texcoord) - vertex.texcoord);
+			error = std::fmax(error, std::fmax(texcoord_error.x, texcoord_error.y) * 1024.0f);
+			if (error > 0.5f + 1e-3f)
+			{
+				std::cerr << std::format("Vertex {} lost too much precision when packed\n", i);
+				return 1;
+			}
+		}
+	}
+
+	// positions beyond the unit cube would be clamped into it, so they are refused
+	const nge::graphics::VertexFormat outside_vertex{vec3(0.0f, 2.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f),
+		vec2(0.0f)};
+	std::vector<nge::graphics::PackedVertexFormat> packed_vertices;
+	bool has_thrown = false;
+	try
+	{
+		nge::graphics::PackVertices(std::span(&outside_vertex, 1), packed_vertices);
+	}
+	catch (const std::runtime_error&)
+	{
+		has_thrown = true;
+	}
+	if (!has_thrown)
+	{
+		std::cerr << "A vertex outside of the unit cube was packed\n";
+		return 1;
+	}
+
+	// bodies switch to and from impostors outside of the hysteresis band only, and keep their path inside of it
+	using nge::graphics::SphereImpostors;
+	const float band_low = SphereImpostors::MAX_SCREEN_RADIUS * (1.0f - SphereImpostors::HYSTERESIS);
+	const float band_high = SphereImpostors::MAX_SCREEN_RADIUS * (1.0f + SphereImpostors::HYSTERESIS);
+	for (const bool was_impostor : {false, true})
+	{
+		const bool is_switching_below = SphereImpostors::ShouldUseImpostor(band_low * 0.99f, was_impostor);
+		const bool is_switching_above = !SphereImpostors::ShouldUseImpostor(band_high * 1.01f, was_impostor);
+		bool is_kept_in_band = true;
+		for (float screen_radius = band_low * 1.01f; screen_radius < band_high * 0.99f; screen_radius += 0.05f)
+			is_kept_in_band = is_kept_in_band && SphereImpostors::ShouldUseImpostor(screen_radius, was_impostor) == was_impostor;
+		if (!is_switching_below || !is_switching_above || !is_kept_in_band)
+		{
+			std::cerr << std::format("A body {} an impostor switches paths wrongly around the hysteresis band\n",
+				was_impostor ? "drawn as" : "not drawn as");
+			return 1;
+		}
+	}
+
+	return 0;
+}
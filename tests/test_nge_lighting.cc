@@ -0,0 +1,74 @@
+#include "nge_lighting.hh"
+#include "nge_random.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <vector>
+#include <algorithm>
+
+using nge::graphics::LightClusters;
+using nge::graphics::PointLight;
+
+int main()
+{
+	// lights scattered around a camera looking at them, not a multiple of 4 so that the scalar path runs too
+	constexpr u32 LIGHT_COUNT = 503;
+	constexpr float NEAR_PLANE = 0.1f;
+	constexpr float FAR_PLANE = 1024.0f;
+	nge::random::Stream random(1);
+	std::vector<PointLight> lights(LIGHT_COUNT);
+	for (PointLight& light : lights)
+	{
+		light.position = vec3(random.NextUniform(-100.0f, 100.0f), random.NextUniform(-20.0f, 20.0f),
+			random.NextUniform(-100.0f, 100.0f));
+		light.radius = random.NextUniform(0.5f, 8.0f);
+		light.color = vec3(1.0f);
+	}
+	const mat4 view = lookAt(vec3(50.0f, 0.0f, 50.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+	const mat4 projection = perspective(radians(45.0f), 1.6f, NEAR_PLANE, FAR_PLANE);
+	LightClusters clusters;
+	clusters.Build(lights, view, projection, NEAR_PLANE, FAR_PLANE);
+
+	usize listed_count = 0, busiest_count = 0;
+	for (u32 cluster = 0; cluster < LightClusters::CLUSTER_COUNT; cluster++)
+	{
+		listed_count += clusters.GetClusterLights(cluster).size();
+		busiest_count = std::max(busiest_count, clusters.GetClusterLights(cluster).size());
+	}
+	std::cout << std::format("{} lights, {} per cluster on average and {} at most\n", LIGHT_COUNT,
+		static_cast<float>(listed_count) / LightClusters::CLUSTER_COUNT, busiest_count);
+	if (busiest_count * 4 > LIGHT_COUNT)
+	{
+		std::cerr << "Clusters must only list the few lights around them\n";
+		return 1;
+	}
+
+	// every visible point a light reaches must find it in its cluster, as a fragment would
+	const mat4 view_projection = projection * view;
+	u32 tested_count = 0;
+	for (u32 light = 0; light < LIGHT_COUNT; light++)
+	{
+		std::vector<vec3> directions(32);
+		std::vector<float> distances(directions.size());
+		random.FillOnSphere(directions);
+		random.FillUniform(distances, 0.0f, lights[light].radius);
+		for (usize i = 0; i < directions.size(); i++)
+		{
+			const vec4 clip = view_projection * vec4(lights[light].position + directions[i] * distances[i], 1.0f);
+			const vec3 ndc = vec3(clip) / clip.w;
+			if (clip.w <= NEAR_PLANE || clip.w >= FAR_PLANE || any(greaterThan(abs(ndc), vec3(1.0f))))
+				continue;
+
+			const auto cluster_lights = clusters.GetClusterLights(clusters.GetCluster(clip.w, vec2(ndc)));
+			if (std::find(cluster_lights.begin(), cluster_lights.end(), light) == cluster_lights.end())
+			{
+				std::cerr << std::format("Light {} is missing from the cluster of a point it reaches\n", light);
+				return 1;
+			}
+			tested_count++;
+		}
+	}
+	std::cout << std::format("{} lit points found their light\n", tested_count);
+	return tested_count > 0 ? 0 : 1;
+}
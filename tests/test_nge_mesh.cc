@@ -0,0 +1,86 @@
+#include "nge_icosphere.hh"
+#include "nge_mesh.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <vector>
+#include <array>
+#include <algorithm>
+
+using nge::graphics::Mesh;
+
+// triangles as positions, each rotated to start from its smallest corner so that the winding is kept, in sorted order
+static std::vector<std::array<vec3, 3>> GetTriangles(const Mesh& mesh)
+{
+	auto less = [](const vec3& a, const vec3& b)
+	{
+		return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+	};
+	std::vector<std::array<vec3, 3>> triangles;
+	for (usize t = 0; t < mesh.vertex_indices.size(); t += 3)
+	{
+		std::array<vec3, 3> triangle;
+		for (usize corner = 0; corner < 3; corner++)
+			triangle[corner] = mesh.vertices[mesh.vertex_indices[t + corner]].position;
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end(), less), triangle.end());
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end(), [less](const auto& a, const auto& b)
+	{
+		return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), less);
+	});
+	return triangles;
+}
+
+int main()
+{
+	// the finest level of the planets, and one which needs 32-bit indices
+	for (const u32 subdivision_count : {5u, 7u})
+	{
+		const Mesh mesh = nge::graphics::GenerateIcosphere(subdivision_count);
+		const u32 vertex_count = static_cast<u32>(mesh.vertices.size());
+		const float acmr = nge::graphics::AnalyzeVertexCache(mesh.vertex_indices, vertex_count);
+
+		Mesh optimized_mesh = mesh;
+		nge::graphics::OptimizeMesh(optimized_mesh);
+		const float optimized_acmr = nge::graphics::AnalyzeVertexCache(optimized_mesh.vertex_indices, vertex_count);
+		std::cout << std::format("{} subdivisions, {} vertices: ACMR {:.3f} optimized to {:.3f}\n", subdivision_count,
+			vertex_count, acmr, optimized_acmr);
+
+		// a regular mesh has about 2 triangles per vertex, so half a vertex per triangle is the best possible
+		if (optimized_acmr > 0.8f || optimized_acmr >= acmr)
+		{
+			std::cerr << "The optimized order must make good use of the vertex cache\n";
+			return 1;
+		}
+		if (subdivision_count == 7 && vertex_count <= 65536)
+		{
+			std::cerr << "The mesh must need 32-bit indices\n";
+			return 1;
+		}
+
+		// the same triangles facing the same way, whatever their order and the order of their vertices
+		// only the two original pole vertices are dropped, since every triangle touching a pole has its own
+		if (optimized_mesh.vertices.size() != mesh.vertices.size() - 2 || GetTriangles(optimized_mesh) != GetTriangles(mesh))
+		{
+			std::cerr << "Optimizing must keep every triangle and used vertex\n";
+			return 1;
+		}
+
+		// vertices come in the order the triangles first use them
+		u32 next_new_index = 0;
+		for (const u32 index : optimized_mesh.vertex_indices)
+		{
+			if (index > next_new_index)
+			{
+				std::cerr << std::format("Vertex {} is used before vertex {}\n", index, next_new_index);
+				return 1;
+			}
+			if (index == next_new_index)
+				next_new_index++;
+		}
+	}
+
+	return 0;
+}
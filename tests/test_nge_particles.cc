@@ -0,0 +1,131 @@
+#include "nge_particles.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <thread>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+// one particle as the pool should move it, step by step
+struct ReferenceParticle
+{
+	vec3 position;
+	vec3 velocity;
+	float life;
+};
+
+int main()
+{
+	// lives spread over a second, so that particles die at every step in any order
+	constexpr u32 CAPACITY = 1003; // not a multiple of the SIMD width
+	constexpr float STEP_TIME = 0.01f;
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> distribution(-5.0f, 5.0f);
+	std::uniform_real_distribution<float> life_distribution(0.05f, 1.0f);
+
+	nge::ParticlePool pool(CAPACITY);
+	nge::ParticlePool other_pool(CAPACITY);
+	std::vector<ReferenceParticle> reference;
+	for (u32 i = 0; i < CAPACITY; i++)
+	{
+		const ReferenceParticle particle{vec3(distribution(generator), distribution(generator), distribution(generator)),
+			vec3(distribution(generator), distribution(generator), distribution(generator)), life_distribution(generator)};
+		pool.Spawn(particle.position, particle.velocity, particle.life);
+		reference.push_back(particle);
+	}
+	if (pool.Spawn(vec3(0.0f), vec3(0.0f), 1.0f) || pool.GetAliveCount() != CAPACITY || other_pool.GetAliveCount() != 0)
+	{
+		std::cerr << "A full pool must refuse new particles, and pools must not share any\n";
+		return 1;
+	}
+
+	for (u32 step = 0; step < 50; step++)
+	{
+		pool.Update(STEP_TIME);
+		std::vector<ReferenceParticle> alive;
+		for (ReferenceParticle particle : reference)
+		{
+			particle.life -= STEP_TIME;
+			particle.velocity *= 1.0f - STEP_TIME;
+			particle.position -= particle.velocity * STEP_TIME;
+			if (particle.life > 0.0f)
+				alive.push_back(particle);
+		}
+		reference = std::move(alive);
+
+		// the alive particles are reordered, but must be the same ones with the same state
+		if (pool.GetAliveCount() != reference.size())
+		{
+			std::cerr << std::format("{} particles alive at step {} instead of {}\n", pool.GetAliveCount(), step,
+				reference.size());
+			return 1;
+		}
+		for (u32 i = 0; i < pool.GetAliveCount(); i++)
+		{
+			const auto found = std::find_if(reference.begin(), reference.end(), [&pool, i](const ReferenceParticle& particle)
+			{
+				// the reference may be compiled with fused multiply-adds the SIMD path does not use
+				constexpr float EPSILON = 1e-5f;
+				return all(lessThan(abs(particle.position - pool.GetPosition(i)), vec3(EPSILON))) &&
+					all(lessThan(abs(particle.velocity - pool.GetVelocity(i)), vec3(EPSILON))) &&
+					std::abs(particle.life - pool.GetLife(i)) < EPSILON;
+			});
+			if (found == reference.end())
+			{
+				std::cerr << std::format("Particle {} at step {} does not match any expected particle\n", i, step);
+				return 1;
+			}
+		}
+	}
+
+	// chunks integrated on several threads end up like a single update
+	constexpr u32 LARGE_CAPACITY = 1'000'000;
+	constexpr u32 THREAD_COUNT = 4;
+	nge::ParticlePool serial_pool(LARGE_CAPACITY);
+	nge::ParticlePool parallel_pool(LARGE_CAPACITY);
+	for (u32 i = 0; i < LARGE_CAPACITY; i++)
+	{
+		const vec3 position(distribution(generator), distribution(generator), distribution(generator));
+		const vec3 velocity(distribution(generator), distribution(generator), distribution(generator));
+		const float life = life_distribution(generator);
+		serial_pool.Spawn(position, velocity, life);
+		parallel_pool.Spawn(position, velocity, life);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	serial_pool.Update(STEP_TIME);
+	const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+	std::cout << std::format("Updated {} particles in {:.3f} ms\n", LARGE_CAPACITY, duration.count());
+
+	std::vector<std::thread> threads;
+	const u32 alive_count = parallel_pool.GetAliveCount();
+	for (u32 t = 0; t < THREAD_COUNT; t++)
+	{
+		threads.emplace_back([&parallel_pool, t, alive_count]
+		{
+			parallel_pool.Integrate(STEP_TIME, alive_count * t / THREAD_COUNT, alive_count * (t + 1) / THREAD_COUNT);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	parallel_pool.RemoveDead();
+
+	if (serial_pool.GetAliveCount() != parallel_pool.GetAliveCount())
+	{
+		std::cerr << "Chunked updates must kill the same particles\n";
+		return 1;
+	}
+	for (u32 i = 0; i < serial_pool.GetAliveCount(); i++)
+	{
+		if (serial_pool.GetPosition(i) != parallel_pool.GetPosition(i) || serial_pool.GetLife(i) != parallel_pool.GetLife(i))
+		{
+			std::cerr << std::format("Particle {} differs between the serial and chunked updates\n", i);
+			return 1;
+		}
+	}
+	return 0;
+}
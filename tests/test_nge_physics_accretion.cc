@@ -0,0 +1,94 @@
+#include "nge_physics.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <cmath>
+#include <stdexcept>
+
+static bool AreNearlyEqual(const float a, const float b, const float tolerance = 1e-4f)
+{
+	return std::fabs(a - b) <= tolerance * std::fmax(1.0f, std::fmax(std::fabs(a), std::fabs(b)));
+}
+
+int main()
+{
+	nge::physics::Simulation sim;
+	sim.SetCollisionResponse(nge::physics::CollisionResponse::Accretion);
+	sim.SetMutualGravity(100.0f, 0.1f);
+
+	// a small cluster of bodies falling onto each other
+	const auto b1 = sim.AddSphericalBody(nge::math::Vector3(0.0f, 0.0f, 0.0f), 10.0f, 1.0f);
+	const auto b2 = sim.AddSphericalBody(nge::math::Vector3(3.0f, 0.0f, 0.0f), 2.0f, 0.5f);
+	const auto b3 = sim.AddSphericalBody(nge::math::Vector3(-4.0f, 1.0f, 0.0f), 1.0f, 0.5f);
+
+	const float total_mass = 13.0f;
+	const float total_volume = 1.0f + 2.0f * 0.125f;
+
+	u32 merge_count = 0;
+	sim.SetImpactCallback([&merge_count](nge::physics::Body* body1, nge::physics::Body* body2)
+	{
+		std::cout << "Bodies " << body1 << " and " << body2 << " merged\n";
+		merge_count++;
+	});
+
+	const float time_step = 1.0f / 240.0f;
+	float elapsed_time = 0.0f;
+	for (u32 frame = 0; frame < 2400 && sim.GetBodyCount() > 1; frame++)
+	{
+		sim.Tick(time_step);
+		elapsed_time += time_step;
+	}
+
+	if (sim.GetBodyCount() != 1 || merge_count != 2)
+	{
+		std::cerr << std::format("Expected all bodies to merge, {} left after {} merges\n", sim.GetBodyCount(), merge_count);
+		return 1;
+	}
+
+	// the heaviest body absorbs the others and keeps its ID
+	if (!sim.IsBodyAlive(b1) || sim.IsBodyAlive(b2) || sim.IsBodyAlive(b3))
+	{
+		std::cerr << "Expected the heaviest body to survive\n";
+		return 1;
+	}
+
+	// looking up an absorbed body fails loudly rather than reading another body, or past the end
+	bool has_thrown = false;
+	try
+	{
+		sim.GetBody(b2);
+	}
+	catch (const std::runtime_error&)
+	{
+		has_thrown = true;
+	}
+	if (!has_thrown)
+	{
+		std::cerr << "Looking up an absorbed body did not throw\n";
+		return 1;
+	}
+
+	const auto& merged = sim.GetBody(b1);
+	const float merged_radius = merged.GetRadius();
+	std::cout << std::format("Merged body of mass {} and radius {} at ({} {} {})\n", merged.GetMass(), merged_radius,
+		merged.GetLocation().x, merged.GetLocation().y, merged.GetLocation().z);
+	if (!AreNearlyEqual(merged.GetMass(), total_mass) ||
+		!AreNearlyEqual(merged_radius * merged_radius * merged_radius, total_volume))
+	{
+		std::cerr << "Mass or volume not conserved\n";
+		return 1;
+	}
+
+	// all bodies started at rest and mutual gravity cancels out, so the momentum only comes from the external forces
+	const float expected_momentum = 3.0f * nge::physics::EARTH_GRAVITY_FORCE.y * elapsed_time;
+	const nge::math::Vector3 momentum = merged.GetVelocity() * merged.GetMass();
+	std::cout << std::format("Momentum ({} {} {}), expected (0 {} 0)\n", momentum.x, momentum.y, momentum.z, expected_momentum);
+	if (std::fabs(momentum.x) > 1e-2f || std::fabs(momentum.z) > 1e-2f || !AreNearlyEqual(momentum.y, expected_momentum, 1e-3f))
+	{
+		std::cerr << "Momentum not conserved\n";
+		return 1;
+	}
+
+	return 0;
+}
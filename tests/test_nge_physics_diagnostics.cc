@@ -0,0 +1,88 @@
+#include "nge_physics_diagnostics.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <cmath>
+
+// a light body on a circular orbit around a heavy one, isolated from any external force
+static nge::physics::DriftStatistics SimulateOrbit(const nge::physics::Integrator integrator, const float time_step)
+{
+	constexpr float GRAVITATIONAL_CONSTANT = 1.0f;
+	constexpr float CENTRAL_MASS = 1000.0f;
+	constexpr float ORBIT_RADIUS = 10.0f;
+
+	nge::physics::Simulation sim;
+	sim.SetIntegrator(integrator);
+	sim.SetMutualGravity(GRAVITATIONAL_CONSTANT);
+
+	const auto sun = sim.AddSphericalBody(nge::math::Vector3(0.0f), CENTRAL_MASS, 1.0f);
+	const auto planet = sim.AddSphericalBody(nge::math::Vector3(ORBIT_RADIUS, 0.0f, 0.0f), 1.0f, 0.1f);
+	sim.SetBodyForce(sun, nge::math::Vector3(0.0f));
+	sim.SetBodyForce(planet, nge::math::Vector3(0.0f));
+
+	// orbit around the common center of mass
+	const float orbital_speed = std::sqrt(GRAVITATIONAL_CONSTANT * (CENTRAL_MASS + 1.0f) / ORBIT_RADIUS);
+	sim.SetBodyVelocity(planet, nge::math::Vector3(0.0f, 0.0f, orbital_speed * CENTRAL_MASS / (CENTRAL_MASS + 1.0f)));
+	sim.SetBodyVelocity(sun, nge::math::Vector3(0.0f, 0.0f, -orbital_speed / (CENTRAL_MASS + 1.0f)));
+
+	// about two full orbits
+	nge::physics::ConservationMonitor monitor(10);
+	const u32 tick_count = static_cast<u32>(4.0f * 3.14159f * ORBIT_RADIUS / orbital_speed / time_step);
+	monitor.Sample(sim);
+	for (u32 tick = 0; tick < tick_count; tick++)
+	{
+		sim.Tick(time_step);
+		monitor.Sample(sim);
+	}
+
+	return monitor.GetStatistics();
+}
+
+int main()
+{
+	const auto euler = SimulateOrbit(nge::physics::Integrator::ExplicitEuler, 1.0f / 60.0f);
+	const auto symplectic = SimulateOrbit(nge::physics::Integrator::SemiImplicitEuler, 1.0f / 60.0f);
+	const auto verlet = SimulateOrbit(nge::physics::Integrator::VelocityVerlet, 1.0f / 60.0f);
+
+	for (const auto& [name, statistics] : {std::pair{"explicit Euler", euler}, {"semi-implicit Euler", symplectic}, {"velocity Verlet", verlet}})
+	{
+		std::cout << std::format("{}: {} samples, max drift of energy {}, momentum {}, angular momentum {}\n", name,
+			statistics.sample_count, statistics.max_energy_drift, statistics.max_momentum_drift,
+			statistics.max_angular_momentum_drift);
+	}
+
+	// mutual gravity is symmetric, so every integrator conserves the linear momentum up to rounding errors
+	// but only symplectic ones conserve the angular momentum
+	for (const auto& statistics : {euler, symplectic, verlet})
+	{
+		if (statistics.max_momentum_drift > 1e-4)
+		{
+			std::cerr << "Momentum drifted\n";
+			return 1;
+		}
+	}
+	for (const auto& statistics : {symplectic, verlet})
+	{
+		if (statistics.max_angular_momentum_drift > 1e-4)
+		{
+			std::cerr << "Angular momentum drifted\n";
+			return 1;
+		}
+	}
+
+	// higher order integrators should be more accurate
+	if (!(verlet.max_energy_drift < symplectic.max_energy_drift && symplectic.max_energy_drift < euler.max_energy_drift))
+	{
+		std::cerr << "Unexpected energy drift ordering\n";
+		return 1;
+	}
+
+	if (verlet.max_energy_drift > 1e-4)
+	{
+		std::cerr << "Velocity Verlet drifted too much\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,119 @@
+#include "nge_pipeline.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <string>
+
+int main()
+{
+	// the writer fills every element with the same value, so a buffer shared by both threads would show up as a mix
+	constexpr u64 PUBLISH_COUNT = 200'000;
+	constexpr usize VALUE_SIZE = 64;
+	// the writer stays at most this many values ahead of the reader, so that the reader acquires while the writer is
+	// publishing many times over, even on a single core where the writer could otherwise finish before the reader starts
+	constexpr u64 MAX_LEAD = 8;
+	nge::TripleBuffer<std::vector<u64>> buffer;
+	std::atomic<u64> acquired_value = 0;
+
+	std::thread writer([&buffer, &acquired_value]
+	{
+		for (u64 value = 1; value <= PUBLISH_COUNT; value++)
+		{
+			while (value > acquired_value.load(std::memory_order_relaxed) + MAX_LEAD)
+				std::this_thread::yield();
+			// half written when the reader gets to run, which it would see if it shared the buffer
+			auto& values = buffer.GetWriteBuffer();
+			values.resize(VALUE_SIZE);
+			std::fill(values.begin(), values.begin() + VALUE_SIZE / 2, value);
+			std::this_thread::yield();
+			std::fill(values.begin() + VALUE_SIZE / 2, values.end(), value);
+			buffer.Publish();
+		}
+	});
+
+	u64 last_value = 0;
+	u64 acquire_count = 0;
+	std::string error;
+	while (last_value < PUBLISH_COUNT && error.empty())
+	{
+		if (!buffer.Acquire())
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		acquire_count++;
+
+		const auto& values = buffer.GetReadBuffer();
+		for (const u64 value : values)
+		{
+			if (value != values.front())
+			{
+				error = std::format("Torn read: {} and {} in the same buffer\n", values.front(), value);
+				break;
+			}
+		}
+		if (error.empty() && values.front() <= last_value)
+			error = std::format("Acquired {} after {}, values must only grow\n", values.front(), last_value);
+		last_value = values.front();
+		acquired_value.store(last_value, std::memory_order_relaxed);
+	}
+	// lets the writer finish when the reader stopped early
+	acquired_value.store(PUBLISH_COUNT, std::memory_order_relaxed);
+	writer.join();
+	if (!error.empty())
+	{
+		std::cerr << error;
+		return 1;
+	}
+	std::cout << std::format("Acquired {} of {} published values\n", acquire_count, PUBLISH_COUNT);
+	if (acquire_count < PUBLISH_COUNT / MAX_LEAD)
+	{
+		std::cerr << std::format("Only {} values were acquired, too few for reads to overlap with publishing\n", acquire_count);
+		return 1;
+	}
+
+	// every requested frame is simulated, frames requested while the simulation is busy being handed to the same step
+	constexpr u32 FRAME_COUNT = 1000;
+	u32 step_count = 0;
+	u32 frame_count = 0;
+	float simulated_time = 0.0f;
+	{
+		nge::SimulationThread<float> simulation([&](const std::span<const nge::timing::Seconds> frame_times, float& snapshot)
+		{
+			step_count++;
+			for (const nge::timing::Seconds time : frame_times)
+			{
+				frame_count++;
+				simulated_time += time;
+			}
+			snapshot = simulated_time;
+		});
+		simulation.Start();
+		if (simulation.GetLatest() != 0.0f)
+		{
+			std::cerr << "The first snapshot must be taken before any time passes\n";
+			return 1;
+		}
+
+		for (u32 frame = 0; frame < FRAME_COUNT; frame++)
+			simulation.Advance(1.0f);
+		// snapshots are only ever published after the whole step, wait for the last one
+		while (simulation.GetLatest() < static_cast<float>(FRAME_COUNT))
+			std::this_thread::yield();
+	}
+	std::cout << std::format("Simulated {} frames in {} steps\n", FRAME_COUNT, step_count);
+	if (simulated_time != static_cast<float>(FRAME_COUNT) || frame_count != FRAME_COUNT || step_count > FRAME_COUNT + 1)
+	{
+		std::cerr << std::format("Simulated {} seconds of {} frames in {} steps instead of {} frames\n", simulated_time,
+			frame_count, step_count, FRAME_COUNT);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include "nge_profiler.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <filesystem>
+
+// number of times a string appears in a file
+static usize CountOccurrences(const std::filesystem::path& path, const std::string_view string)
+{
+	std::ifstream file(path);
+	std::stringstream contents;
+	contents << file.rdbuf();
+	const std::string text = contents.str();
+
+	usize count = 0;
+	for (usize position = text.find(string); position != std::string::npos; position = text.find(string, position + 1))
+		count++;
+	return count;
+}
+
+int main()
+{
+	using nge::profiling::Profiler;
+	using nge::profiling::CpuScope;
+	Profiler& profiler = Profiler::Get();
+	const auto path = std::filesystem::temp_directory_path() / "test_nge_profiler.json";
+
+	{
+		const CpuScope scope("\"not captured\"");
+	}
+
+	// several threads recording at once, each into its own track
+	constexpr u32 THREAD_COUNT = 4;
+	constexpr u32 SCOPE_COUNT = 1000;
+	profiler.StartCapture();
+	std::vector<std::thread> threads;
+	for (u32 t = 0; t < THREAD_COUNT; t++)
+	{
+		threads.emplace_back([&profiler, t]
+		{
+			profiler.SetThreadName(std::format("Worker {}", t));
+			for (u32 i = 0; i < SCOPE_COUNT; i++)
+			{
+				const CpuScope outer("outer");
+				const CpuScope inner("inner");
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	profiler.StopCapture();
+
+	{
+		const CpuScope scope("\"not captured\"");
+	}
+
+	const usize event_count = profiler.ExportChromeTrace(path);
+	std::cout << std::format("Exported {} events\n", event_count);
+	if (event_count != 2 * THREAD_COUNT * SCOPE_COUNT ||
+		CountOccurrences(path, "\"name\":\"outer\"") != THREAD_COUNT * SCOPE_COUNT ||
+		CountOccurrences(path, "\"name\":\"inner\"") != THREAD_COUNT * SCOPE_COUNT)
+	{
+		std::cerr << "Every scope of the capture must be exported once\n";
+		return 1;
+	}
+	if (CountOccurrences(path, "not captured") != 0 || CountOccurrences(path, "\"name\":\"Worker 3\"") != 1)
+	{
+		std::cerr << "Only the scopes of the capture must be exported, with their thread names\n";
+		return 1;
+	}
+
+	// a new capture replaces the previous one, and a full track drops events instead of growing
+	profiler.StartCapture();
+	for (u32 i = 0; i < nge::profiling::EventTrack::CAPACITY + 10; i++)
+		const CpuScope scope("overflow");
+	profiler.StopCapture();
+	const usize overflow_count = profiler.ExportChromeTrace(path);
+	if (overflow_count != nge::profiling::EventTrack::CAPACITY || CountOccurrences(path, "\"name\":\"outer\"") != 0 ||
+		CountOccurrences(path, "\"count\":10}") != 1)
+	{
+		std::cerr << std::format("Exported {} events instead of {} from the last capture\n", overflow_count,
+			nge::profiling::EventTrack::CAPACITY);
+		return 1;
+	}
+
+	std::filesystem::remove(path);
+	return 0;
+}
@@ -0,0 +1,148 @@
+#include "nge_headless.hh"
+#include "nge_shader.hh"
+#include "nge_program_cache.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using nge::graphics::ProgramCache;
+using nge::graphics::Shader;
+
+constexpr const char* VERTEX_PATH = "shaders/skybox.vs";
+constexpr const char* FRAGMENT_PATH = "shaders/skybox.fs";
+
+static std::string ReadFile(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::stringstream stream;
+	stream << file.rdbuf();
+	return stream.str();
+}
+
+static void WriteFile(const std::filesystem::path& path, const std::string& data)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(data.data(), (std::streamsize)data.size());
+}
+
+// the binaries in the cache, sorted so that runs compare the same way
+static std::vector<std::filesystem::path> ListBinaries(const std::filesystem::path& directory)
+{
+	std::vector<std::filesystem::path> paths;
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+		paths.push_back(entry.path());
+	std::sort(paths.begin(), paths.end());
+	return paths;
+}
+
+// the key the shader looks its program up with, from the same sources
+static u64 ComputeKey(const ProgramCache& cache)
+{
+	const std::string vertex_source = ReadFile(VERTEX_PATH);
+	const std::string fragment_source = ReadFile(FRAGMENT_PATH);
+	const std::string_view sources[] = {vertex_source, fragment_source};
+	return cache.ComputeKey(sources);
+}
+
+// whether the cache gives a working program for the key, deleting it
+static bool CanLoad(const ProgramCache& cache, const u64 key)
+{
+	const GLuint program = cache.Load(key);
+	glDeleteProgram(program);
+	return program != 0;
+}
+
+// the cached binary is damaged, which must make loading it fail, and a shader made then must compile its program and
+// store it again in place of the damaged one
+static bool TestFallback(const ProgramCache& cache, const std::filesystem::path& path, const std::string& damaged,
+	const std::string_view damage)
+{
+	const std::string stored = ReadFile(path);
+	WriteFile(path, damaged);
+	const u64 key = ComputeKey(cache);
+	if (CanLoad(cache, key))
+	{
+		std::cerr << std::format("A {} binary was loaded\n", damage);
+		return false;
+	}
+
+	{
+		const Shader shader(VERTEX_PATH, FRAGMENT_PATH, &cache);
+	}
+	if (ReadFile(path) != stored || !CanLoad(cache, key))
+	{
+		std::cerr << std::format("A {} binary was not replaced by a compiled one\n", damage);
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	// runs from bin/, where the shaders are, with whatever EGL driver there is (llvmpipe on build machines)
+	const nge::HeadlessWindow window(nge::Extent2D(16, 16), 1);
+	const auto directory = std::filesystem::temp_directory_path() / "nge_test_program_cache";
+	std::filesystem::remove_all(directory);
+
+	const ProgramCache cache(directory);
+	if (!cache.IsSupported())
+	{
+		std::cerr << "The driver has no program binary format\n";
+		return 1;
+	}
+	const u64 key = ComputeKey(cache);
+	if (CanLoad(cache, key))
+	{
+		std::cerr << "An empty cache loaded a program\n";
+		return 1;
+	}
+
+	// linking a program stores it, and it is then loaded back
+	{
+		const Shader shader(VERTEX_PATH, FRAGMENT_PATH, &cache);
+	}
+	const auto paths = ListBinaries(directory);
+	if (paths.size() != 1 || !CanLoad(cache, key))
+	{
+		std::cerr << std::format("A linked program was not loaded back, {} files were stored\n", paths.size());
+		return 1;
+	}
+	const std::filesystem::path path = paths.front();
+	const std::string stored = ReadFile(path);
+
+	// a write cut short, and bytes of the binary itself changed, past the magic and the format
+	std::string corrupted = stored;
+	for (usize i = corrupted.size() / 2; i < corrupted.size() / 2 + 16; i++)
+		corrupted[i] = static_cast<char>(~corrupted[i]);
+	if (!TestFallback(cache, path, stored.substr(0, stored.size() / 2), "truncated") ||
+		!TestFallback(cache, path, corrupted, "corrupted"))
+		return 1;
+
+	// another driver has its own binaries, so it compiles the program instead of loading this driver's one
+	const ProgramCache other_cache(directory, "another vendor\nanother renderer\nanother version\n");
+	const u64 other_key = ComputeKey(other_cache);
+	if (other_key == key || CanLoad(other_cache, other_key))
+	{
+		std::cerr << "Another driver loaded this driver's binary\n";
+		return 1;
+	}
+	{
+		const Shader shader(VERTEX_PATH, FRAGMENT_PATH, &other_cache);
+	}
+	if (ListBinaries(directory).size() != 2 || ReadFile(path) != stored)
+	{
+		std::cerr << "Another driver did not store its own binary next to this driver's one\n";
+		return 1;
+	}
+
+	std::filesystem::remove_all(directory);
+	std::cout << "The program cache passed\n";
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include "nge_random.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+using nge::random::Stream;
+using nge::random::Xoshiro256pp;
+
+// mean and variance of values
+static std::pair<double, double> ComputeMoments(const std::vector<float>& values)
+{
+	double sum = 0.0, square_sum = 0.0;
+	for (const float value : values)
+	{
+		sum += value;
+		square_sum += double(value) * value;
+	}
+	const double mean = sum / values.size();
+	return {mean, square_sum / values.size() - mean * mean};
+}
+
+int main()
+{
+	// first outputs of the reference implementation from the state {1, 2, 3, 4}
+	Xoshiro256pp reference({1, 2, 3, 4});
+	const u64 expected[] = {41943041, 58720359, 3588806011781223};
+	for (const u64 value : expected)
+	{
+		const u64 output = reference.Next();
+		if (output != value)
+		{
+			std::cerr << std::format("xoshiro256++ gave {} instead of {}\n", output, value);
+			return 1;
+		}
+	}
+
+	// every lane of a stream is the scalar generator of its own stream
+	constexpr u64 SEED = 1234;
+	Stream stream(SEED, 5);
+	std::vector<float> uniforms(1003);
+	stream.FillUniform(uniforms);
+	for (u32 lane = 0; lane < Stream::LANE_COUNT; lane++)
+	{
+		Xoshiro256pp generator(SEED, 5 * Stream::LANE_COUNT + lane);
+		for (usize i = lane; i < uniforms.size(); i += Stream::LANE_COUNT)
+		{
+			if (uniforms[i] != nge::random::ToUnitFloat(generator.Next()))
+			{
+				std::cerr << std::format("Value {} does not come from lane {}\n", i, lane);
+				return 1;
+			}
+		}
+	}
+
+	// the same seed and stream give the same values, another stream other ones
+	std::vector<float> same_values(1000), other_values(1000), values(1000);
+	Stream(SEED, 5).FillUniform(same_values);
+	Stream(SEED, 6).FillUniform(other_values);
+	std::copy_n(uniforms.begin(), values.size(), values.begin());
+	if (values != same_values || values == other_values)
+	{
+		std::cerr << "Values must only depend on the seed and stream\n";
+		return 1;
+	}
+
+	// distributions
+	constexpr usize SAMPLE_COUNT = 1'000'000;
+	std::vector<float> samples(SAMPLE_COUNT);
+	stream.FillUniform(samples, -1.0f, 3.0f);
+	const auto [uniform_mean, uniform_variance] = ComputeMoments(samples);
+	for (const float sample : samples)
+	{
+		if (sample < -1.0f || sample >= 3.0f)
+		{
+			std::cerr << std::format("Uniform sample {} out of [-1, 3)\n", sample);
+			return 1;
+		}
+	}
+	stream.FillGaussian(samples, 2.0f, 0.5f);
+	const auto [gaussian_mean, gaussian_variance] = ComputeMoments(samples);
+	std::cout << std::format("Uniform mean {:.4f} variance {:.4f}, gaussian mean {:.4f} variance {:.4f}\n",
+		uniform_mean, uniform_variance, gaussian_mean, gaussian_variance);
+	if (std::abs(uniform_mean - 1.0) > 0.01 || std::abs(uniform_variance - 16.0 / 12.0) > 0.01 ||
+		std::abs(gaussian_mean - 2.0) > 0.01 || std::abs(gaussian_variance - 0.25) > 0.01)
+	{
+		std::cerr << "Samples do not follow their distribution\n";
+		return 1;
+	}
+
+	std::vector<vec3> directions(SAMPLE_COUNT);
+	stream.FillOnSphere(directions);
+	vec3 direction_sum(0.0f);
+	for (const vec3& direction : directions)
+	{
+		if (std::abs(length(direction) - 1.0f) > 1e-5f)
+		{
+			std::cerr << "Directions must be of unit length\n";
+			return 1;
+		}
+		direction_sum += direction;
+	}
+	if (length(direction_sum) / SAMPLE_COUNT > 0.01f)
+	{
+		std::cerr << "Directions must be spread evenly\n";
+		return 1;
+	}
+
+	// what spawning 10^5 particles takes: a position and a velocity each
+	constexpr usize PARTICLE_COUNT = 100'000;
+	std::vector<float> spawn_values(PARTICLE_COUNT * 6);
+	const auto start = std::chrono::steady_clock::now();
+	stream.FillUniform(spawn_values);
+	const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+	std::cout << std::format("Drew {} uniforms in {:.3f} ms\n", spawn_values.size(), duration.count());
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include "nge_render_queue.hh"
+#include "nge_random.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <string_view>
+
+using nge::graphics::DrawPacket;
+using nge::graphics::RenderLayer;
+using nge::graphics::RenderQueue;
+
+// sorts the keys with the queue, and checks the order against a stable sort of their indices
+static bool TestSort(RenderQueue& queue, const std::vector<u64>& keys, const std::string_view name)
+{
+	queue.Clear();
+	for (const u64 key : keys)
+	{
+		DrawPacket packet;
+		packet.sort_key = key;
+		queue.Submit(packet);
+	}
+	const std::span<const u32> order = queue.Sort();
+
+	std::vector<u32> expected_order(keys.size());
+	std::iota(expected_order.begin(), expected_order.end(), 0u);
+	std::stable_sort(expected_order.begin(), expected_order.end(), [&keys](const u32 a, const u32 b) {return keys[a] < keys[b];});
+	if (!std::equal(order.begin(), order.end(), expected_order.begin(), expected_order.end()))
+	{
+		std::cerr << std::format("The {} keys are not sorted like a stable sort would\n", name);
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	nge::random::Xoshiro256pp random(1);
+	RenderQueue queue;
+
+	// the same queue sorts every case, so that scratch space left by one case does not leak into the next
+	std::vector<u64> random_keys(1000);
+	for (u64& key : random_keys)
+		key = random.Next();
+	// many duplicates, and bytes which every key shares and which the sort skips
+	std::vector<u64> duplicate_keys(1000);
+	for (u64& key : duplicate_keys)
+		key = 0x0100000000000000ull | ((random.Next() % 4) << 32) | (random.Next() % 3);
+	// keys made like the game's, few programs and materials with depths that differ in their low bytes only
+	std::vector<u64> draw_keys(1000);
+	for (u64& key : draw_keys)
+		key = RenderQueue::MakeSortKey(static_cast<RenderLayer>(random.Next() % 3), static_cast<GLuint>(random.Next() % 5),
+			static_cast<u32>(random.Next() % 3), 10.0f + static_cast<float>(random.Next() % 100) * 1e-5f);
+	if (!TestSort(queue, random_keys, "random") || !TestSort(queue, duplicate_keys, "duplicate") ||
+		!TestSort(queue, draw_keys, "draw") || !TestSort(queue, std::vector<u64>(100, 0x1234), "equal") ||
+		!TestSort(queue, std::vector<u64>{42}, "single") || !TestSort(queue, {}, "empty"))
+		return 1;
+
+	// each field outranks the ones after it, and draws get further away from the camera in opaque layers
+	struct Case
+	{
+		u64 first;
+		u64 second;
+		std::string_view name;
+	};
+	const Case cases[] =
+	{
+		{RenderQueue::MakeSortKey(RenderLayer::Opaque, 9, 9, 1000.0f), RenderQueue::MakeSortKey(RenderLayer::Sky, 1, 1, 1.0f),
+			"layer over program"},
+		{RenderQueue::MakeSortKey(RenderLayer::Opaque, 1, 9, 1000.0f), RenderQueue::MakeSortKey(RenderLayer::Opaque, 2, 1, 1.0f),
+			"program over material"},
+		{RenderQueue::MakeSortKey(RenderLayer::Opaque, 1, 1, 1000.0f), RenderQueue::MakeSortKey(RenderLayer::Opaque, 1, 2, 1.0f),
+			"material over depth"},
+		{RenderQueue::MakeSortKey(RenderLayer::Opaque, 1, 1, 1.0f), RenderQueue::MakeSortKey(RenderLayer::Opaque, 1, 1, 1.5f),
+			"front to back"},
+		{RenderQueue::MakeSortKey(RenderLayer::Opaque, 1, 1, 0.001f), RenderQueue::MakeSortKey(RenderLayer::Opaque, 1, 1, 1e6f),
+			"front to back over orders of magnitude"},
+		{RenderQueue::MakeSortKey(RenderLayer::Opaque, 1, 1, -1.0f), RenderQueue::MakeSortKey(RenderLayer::Opaque, 1, 1, 0.5f),
+			"behind the camera first"},
+		{RenderQueue::MakeSortKey(RenderLayer::Overlay, 1, 1, 2.0f), RenderQueue::MakeSortKey(RenderLayer::Overlay, 1, 1, 1.0f),
+			"overlays back to front"},
+		{RenderQueue::MakeSortKey(RenderLayer::Overlay, 9, 9, 2.0f), RenderQueue::MakeSortKey(RenderLayer::Overlay, 1, 1, 1.0f),
+			"overlay depth over program"},
+	};
+	for (const Case& c : cases)
+	{
+		if (c.first >= c.second)
+		{
+			std::cerr << std::format("Sort keys are out of order: {}\n", c.name);
+			return 1;
+		}
+	}
+
+	return 0;
+}
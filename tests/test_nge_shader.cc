@@ -0,0 +1,58 @@
+#include "nge_shader.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+using nge::graphics::Shader;
+
+int main()
+{
+	// the header goes after the #version line, and the #line directive numbers the next line as it is in the source
+	struct Case
+	{
+		std::string_view source;
+		std::string_view header;
+		std::string_view expected;
+		std::string_view name;
+	};
+	const Case cases[] =
+	{
+		{"#version 330 core\nvoid main() {}\n", "const uint A = 1u;",
+			"#version 330 core\nconst uint A = 1u;\n#line 2\nvoid main() {}\n", "a #version line"},
+		{"#version 330 core", "const uint A = 1u;", "#version 330 core\nconst uint A = 1u;\n#line 2\n",
+			"a #version line without a newline"},
+		{"void main() {}\n", "const uint A = 1u;", "const uint A = 1u;\n#line 1\nvoid main() {}\n", "no #version line"},
+		{"#version 330 core\nvoid main() {}\n", "", "#version 330 core\nvoid main() {}\n", "an empty header"},
+	};
+	for (const Case& c : cases)
+	{
+		const std::string result = Shader::InsertHeader(std::string(c.source), c.header);
+		if (result != c.expected)
+		{
+			std::cerr << std::format("The header is misplaced in a source with {}:\n{}\n", c.name, result);
+			return 1;
+		}
+	}
+
+	// a #version line after anything else would stop being first
+	bool has_thrown = false;
+	try
+	{
+		Shader::InsertHeader("// comment\n#version 330 core\nvoid main() {}\n", "const uint A = 1u;");
+	}
+	catch (const std::runtime_error&)
+	{
+		has_thrown = true;
+	}
+	if (!has_thrown)
+	{
+		std::cerr << "A header was placed before the #version line\n";
+		return 1;
+	}
+
+	return 0;
+}
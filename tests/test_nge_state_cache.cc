@@ -0,0 +1,118 @@
+#include "nge_headless.hh"
+#include "nge_state_cache.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <string_view>
+#include <stdexcept>
+
+using nge::graphics::StateCache;
+
+static GLint GetInteger(const GLenum name)
+{
+	GLint value = 0;
+	glGetIntegerv(name, &value);
+	return value;
+}
+
+// the calls made since the last check were issued and filtered as expected, and GL is in the state the cache believes
+static bool Check(StateCache& cache, const u64 issued_calls, const u64 filtered_calls, const bool is_state_expected,
+	const std::string_view name)
+{
+	const StateCache::Statistics statistics = cache.GetStatistics();
+	cache.ResetStatistics();
+	if (statistics.issued_calls != issued_calls || statistics.filtered_calls != filtered_calls || !is_state_expected)
+	{
+		std::cerr << std::format("{}: {} calls issued and {} filtered, expected {} and {}{}\n", name,
+			statistics.issued_calls, statistics.filtered_calls, issued_calls, filtered_calls,
+			is_state_expected ? "" : ", and GL is not in the expected state");
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	// with whatever EGL driver there is (llvmpipe on build machines)
+	const nge::HeadlessWindow window(nge::Extent2D(16, 16), 1);
+	StateCache cache;
+
+	GLuint vertex_arrays[2];
+	glGenVertexArrays(2, vertex_arrays);
+	GLuint textures[3];
+	glGenTextures(3, textures);
+
+	// the first calls are issued whatever the state, repeating them is filtered
+	cache.BindVertexArray(vertex_arrays[0]);
+	cache.SetDepthTest(true);
+	cache.SetDepthFunc(GL_LEQUAL);
+	cache.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	if (!Check(cache, 4, 0, GetInteger(GL_VERTEX_ARRAY_BINDING) == (GLint)vertex_arrays[0] && glIsEnabled(GL_DEPTH_TEST) &&
+		GetInteger(GL_DEPTH_FUNC) == GL_LEQUAL && GetInteger(GL_BLEND_SRC_RGB) == GL_SRC_ALPHA, "First calls"))
+		return 1;
+	cache.BindVertexArray(vertex_arrays[0]);
+	cache.SetDepthTest(true);
+	cache.SetDepthFunc(GL_LEQUAL);
+	cache.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	if (!Check(cache, 0, 4, true, "Repeated calls"))
+		return 1;
+	// either blend factor changing is a change
+	cache.SetBlendFunc(GL_SRC_ALPHA, GL_ONE);
+	cache.SetDepthTest(false);
+	cache.BindVertexArray(vertex_arrays[1]);
+	if (!Check(cache, 3, 0, GetInteger(GL_BLEND_DST_RGB) == GL_ONE && !glIsEnabled(GL_DEPTH_TEST) &&
+		GetInteger(GL_VERTEX_ARRAY_BINDING) == (GLint)vertex_arrays[1], "Changed calls"))
+		return 1;
+
+	// a bind counts the texture and the active unit, which only changes when another unit is bound to
+	cache.BindTexture(0, GL_TEXTURE_2D, textures[0]);
+	cache.BindTexture(0, GL_TEXTURE_2D_ARRAY, textures[1]);
+	cache.BindTexture(3, GL_TEXTURE_2D, textures[2]);
+	const GLint texture_3 = GetInteger(GL_TEXTURE_BINDING_2D);
+	glActiveTexture(GL_TEXTURE0);
+	const bool are_bound = texture_3 == (GLint)textures[2] && GetInteger(GL_TEXTURE_BINDING_2D) == (GLint)textures[0] &&
+		GetInteger(GL_TEXTURE_BINDING_2D_ARRAY) == (GLint)textures[1];
+	cache.Invalidate(); // the active unit was changed behind its back
+	if (!Check(cache, 5, 1, are_bound, "Texture binds"))
+		return 1;
+
+	// every call is issued again after invalidating
+	cache.BindTexture(3, GL_TEXTURE_2D, textures[2]);
+	cache.BindVertexArray(vertex_arrays[1]);
+	if (!Check(cache, 3, 0, GetInteger(GL_ACTIVE_TEXTURE) == GL_TEXTURE3, "Calls after invalidating"))
+		return 1;
+
+	// deleted names may come back, so binding them again is issued
+	glDeleteTextures(1, &textures[2]);
+	cache.OnTextureDeleted(textures[2]);
+	glDeleteVertexArrays(1, &vertex_arrays[1]);
+	cache.OnVertexArrayDeleted(vertex_arrays[1]);
+	glGenTextures(1, &textures[2]);
+	glGenVertexArrays(1, &vertex_arrays[1]);
+	cache.BindTexture(3, GL_TEXTURE_2D, textures[2]);
+	cache.BindVertexArray(vertex_arrays[1]);
+	if (!Check(cache, 2, 1, GetInteger(GL_TEXTURE_BINDING_2D) == (GLint)textures[2] &&
+		GetInteger(GL_VERTEX_ARRAY_BINDING) == (GLint)vertex_arrays[1], "Binds of deleted names"))
+		return 1;
+
+	// targets the cache does not track would share another target's slot
+	bool has_thrown = false;
+	try
+	{
+		cache.BindTexture(0, GL_TEXTURE_3D, textures[0]);
+	}
+	catch (const std::runtime_error&)
+	{
+		has_thrown = true;
+	}
+	if (!has_thrown)
+	{
+		std::cerr << "An untracked texture target was bound\n";
+		return 1;
+	}
+
+	glDeleteTextures(3, textures);
+	glDeleteVertexArrays(2, vertex_arrays);
+	return 0;
+}
@@ -0,0 +1,130 @@
+#include "nge_headless.hh"
+#include "nge_streaming.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <vector>
+#include <stdexcept>
+
+using nge::graphics::StreamingBuffer;
+using nge::graphics::StreamAllocation;
+
+// runs every check on one path of the buffer, returns whether they all passed
+static bool TestStreamingBuffer(const bool allow_persistent)
+{
+	constexpr usize CAPACITY = 1000;
+	StreamingBuffer buffer(CAPACITY, allow_persistent);
+	const char* path = buffer.IsPersistent() ? "persistent" : "orphaning";
+	if (buffer.IsPersistent() != allow_persistent)
+	{
+		std::cerr << std::format("The {} path must only be used when the persistent one is not allowed\n", path);
+		return false;
+	}
+
+	// allocations are aligned and follow each other
+	buffer.BeginFrame();
+	const StreamAllocation first = buffer.Allocate(3);
+	const StreamAllocation second = buffer.Allocate(5, 64);
+	const StreamAllocation third = buffer.Allocate(7);
+	if (first.offset % 16 != 0 || second.offset % 64 != 0 || third.offset % 16 != 0 || second.offset < first.offset + 3 ||
+		third.offset < second.offset + 5 || third.offset - first.offset != static_cast<usize>(static_cast<u8*>(third.data) - static_cast<u8*>(first.data)))
+	{
+		std::cerr << std::format("Badly aligned allocations on the {} path: offsets {}, {} and {}\n", path, first.offset,
+			second.offset, third.offset);
+		return false;
+	}
+
+	// a frame which needs more than the capacity throws, here the capacity on top of what it already allocated
+	bool has_thrown = false;
+	try
+	{
+		buffer.Allocate(CAPACITY);
+	}
+	catch (const std::runtime_error&)
+	{
+		has_thrown = true;
+	}
+	if (!has_thrown)
+	{
+		std::cerr << std::format("Exceeding the capacity on the {} path must throw\n", path);
+		return false;
+	}
+	buffer.Flush();
+	buffer.EndFrame();
+
+	// many more frames than regions, each read by the GPU after the CPU moved on to the next ones: a region rewritten
+	// before the GPU read it, or storage not orphaned, would show up as a frame holding another frame's values
+	// (llvmpipe copies buffers as soon as asked, so only drivers which queue the copies can catch a missing wait)
+	constexpr u32 FRAME_COUNT = StreamingBuffer::FRAME_COUNT * 4 + 1;
+	constexpr u32 VALUE_COUNT = CAPACITY / sizeof(u32);
+	GLuint results = 0;
+	glGenBuffers(1, &results);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, results);
+	glBufferData(GL_COPY_WRITE_BUFFER, FRAME_COUNT * VALUE_COUNT * sizeof(u32), nullptr, GL_STATIC_READ);
+	std::vector<usize> offsets;
+	for (u32 frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		buffer.BeginFrame();
+		const std::vector<u32> values(VALUE_COUNT, frame + 1);
+		const StreamAllocation allocation = buffer.Write(std::span<const u32>(values));
+		offsets.push_back(allocation.offset);
+		buffer.Flush();
+
+		glBindBuffer(GL_COPY_READ_BUFFER, allocation.buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)allocation.offset,
+			(GLintptr)(frame * VALUE_COUNT * sizeof(u32)), (GLsizeiptr)allocation.size);
+		buffer.EndFrame();
+	}
+
+	std::vector<u32> copied(FRAME_COUNT * VALUE_COUNT);
+	glGetBufferSubData(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)(copied.size() * sizeof(u32)), copied.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glDeleteBuffers(1, &results);
+	for (u32 frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		for (u32 i = 0; i < VALUE_COUNT; i++)
+		{
+			if (copied[frame * VALUE_COUNT + i] != frame + 1)
+			{
+				std::cerr << std::format("Frame {} read {} from the {} path instead of {}\n", frame,
+					copied[frame * VALUE_COUNT + i], path, frame + 1);
+				return false;
+			}
+		}
+	}
+
+	// the persistent path cycles through its regions, the orphaning one always writes at the start of new storage
+	for (u32 frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		const bool is_expected_offset = buffer.IsPersistent() ?
+			offsets[frame] == offsets[frame % StreamingBuffer::FRAME_COUNT] &&
+				(frame < 1 || offsets[frame] != offsets[frame - 1]) :
+			offsets[frame] == 0;
+		if (!is_expected_offset)
+		{
+			std::cerr << std::format("Frame {} was written at offset {} on the {} path\n", frame, offsets[frame], path);
+			return false;
+		}
+	}
+
+	std::cout << std::format("The {} path passed\n", path);
+	return true;
+}
+
+int main()
+{
+	// with whatever EGL driver there is (llvmpipe on build machines), which must have GL 4.4 for the persistent path
+	const nge::HeadlessWindow window(nge::Extent2D(16, 16), 1);
+	if (!GLAD_GL_VERSION_4_4)
+	{
+		std::cerr << "The driver needs GL 4.4 to test the persistent path\n";
+		return 1;
+	}
+
+	if (!TestStreamingBuffer(true) || !TestStreamingBuffer(false))
+		return 1;
+
+	return 0;
+}
@@ -0,0 +1,140 @@
+#include "nge_headless.hh"
+#include "nge_texture.hh"
+
+// std headers
+#include <iostream>
+#include <format>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+using nge::graphics::Image;
+using nge::graphics::TextureArray;
+
+// image whose texels are all the given color
+static Image MakeImage(const u32 width, const u32 height, const u8 red, const u8 green, const u8 blue)
+{
+	Image image{width, height, {}};
+	for (u32 i = 0; i < width * height; i++)
+		image.pixels.insert(image.pixels.end(), {red, green, blue});
+	return image;
+}
+
+int main()
+{
+	// sizes to resample from and to: identity, upsampling, downsampling by whole and odd factors, and single texels
+	struct Case
+	{
+		u32 source_size;
+		u32 destination_size;
+	};
+	const Case cases[] = {{8, 8}, {8, 16}, {3, 7}, {16, 8}, {7, 3}, {1000, 1}, {1, 1}, {1, 5}, {5, 1}};
+	for (const Case& c : cases)
+	{
+		const auto taps = nge::graphics::ComputeResampleTaps(c.source_size, c.destination_size);
+		if (taps.size() != c.destination_size)
+		{
+			std::cerr << std::format("{} taps lists from {} to {}\n", taps.size(), c.source_size, c.destination_size);
+			return 1;
+		}
+		for (u32 destination = 0; destination < c.destination_size; destination++)
+		{
+			float weight_sum = 0.0f;
+			for (const auto& tap : taps[destination])
+			{
+				if (tap.source >= c.source_size || tap.weight <= 0.0f)
+				{
+					std::cerr << std::format("Texel {} from {} to {} reads texel {} with a weight of {}\n", destination,
+						c.source_size, c.destination_size, tap.source, tap.weight);
+					return 1;
+				}
+				weight_sum += tap.weight;
+			}
+			if (taps[destination].empty() || std::fabs(weight_sum - 1.0f) > 1e-5f)
+			{
+				std::cerr << std::format("Texel {} from {} to {} has weights summing to {}\n", destination,
+					c.source_size, c.destination_size, weight_sum);
+				return 1;
+			}
+			// the same size copies every texel
+			if (c.source_size == c.destination_size &&
+				(taps[destination].size() != 1 || taps[destination].front().source != destination))
+			{
+				std::cerr << std::format("Texel {} is not copied as is when resampling to the same size\n", destination);
+				return 1;
+			}
+		}
+	}
+
+	// a single texel is stretched over any size, and a uniform image stays uniform whether enlarged or shrunk
+	const Image single_texel = MakeImage(1, 1, 10, 200, 30);
+	const Image uniform = MakeImage(7, 5, 90, 0, 255);
+	const struct
+	{
+		const Image& source;
+		u32 width;
+		u32 height;
+	} uniform_cases[] = {{single_texel, 5, 3}, {single_texel, 1, 1}, {uniform, 16, 9}, {uniform, 3, 2}, {uniform, 1, 1}};
+	for (const auto& c : uniform_cases)
+	{
+		const Image resampled = nge::graphics::ResampleImage(c.source, c.width, c.height);
+		const Image expected = MakeImage(c.width, c.height, c.source.pixels[0], c.source.pixels[1], c.source.pixels[2]);
+		if (resampled.width != c.width || resampled.height != c.height || resampled.pixels != expected.pixels)
+		{
+			std::cerr << std::format("A uniform {} by {} image resampled to {} by {} is not uniform anymore\n",
+				c.source.width, c.source.height, c.width, c.height);
+			return 1;
+		}
+	}
+
+	// enlarging a ramp keeps it between its ends and increasing, shrinking it keeps its mean
+	Image ramp{8, 1, {}};
+	for (u32 x = 0; x < ramp.width; x++)
+		ramp.pixels.insert(ramp.pixels.end(), {static_cast<u8>(x * 32), static_cast<u8>(x * 32), static_cast<u8>(x * 32)});
+	const Image enlarged_ramp = nge::graphics::ResampleImage(ramp, 32, 1);
+	for (u32 x = 1; x < enlarged_ramp.width; x++)
+	{
+		if (enlarged_ramp.pixels[x * Image::CHANNELS] < enlarged_ramp.pixels[(x - 1) * Image::CHANNELS])
+		{
+			std::cerr << std::format("The enlarged ramp decreases at texel {}\n", x);
+			return 1;
+		}
+	}
+	const Image shrunk_ramp = nge::graphics::ResampleImage(ramp, 4, 1);
+	float mean = 0.0f;
+	for (u32 x = 0; x < shrunk_ramp.width; x++)
+		mean += static_cast<float>(shrunk_ramp.pixels[x * Image::CHANNELS]) / static_cast<float>(shrunk_ramp.width);
+	// 112 is the mean of the ramp, the edges being clamped shift it by less than a texel step
+	if (enlarged_ramp.pixels.front() != 0 || enlarged_ramp.pixels.back() != 224 || std::fabs(mean - 112.0f) > 16.0f)
+	{
+		std::cerr << std::format("The resampled ramp goes from {} to {}, and has a mean of {} once shrunk\n",
+			enlarged_ramp.pixels.front(), enlarged_ramp.pixels.back(), mean);
+		return 1;
+	}
+
+	// layers read back from GL: a resampled image, and an empty one cleared to black over a previous image
+	// with whatever EGL driver there is (llvmpipe on build machines)
+	const nge::HeadlessWindow window(nge::Extent2D(16, 16), 1);
+	TextureArray textures(4, 2, 2);
+	textures.SetLayer(0, ramp);
+	textures.SetLayer(1, MakeImage(4, 2, 255, 255, 255));
+	textures.SetLayer(1, Image());
+	std::vector<u8> layers(4 * 2 * 2 * Image::CHANNELS, 1);
+	textures.Bind(0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGB, GL_UNSIGNED_BYTE, layers.data());
+	const Image expected_layer = nge::graphics::ResampleImage(ramp, 4, 2);
+	const usize layer_size = expected_layer.pixels.size();
+	if (!std::equal(expected_layer.pixels.begin(), expected_layer.pixels.end(), layers.begin()))
+	{
+		std::cerr << "A layer does not hold its resampled image\n";
+		return 1;
+	}
+	if (std::any_of(layers.begin() + static_cast<std::ptrdiff_t>(layer_size), layers.end(), [](const u8 value) {return value != 0;}))
+	{
+		std::cerr << "A layer set to an empty image is not black\n";
+		return 1;
+	}
+
+	return 0;
+}